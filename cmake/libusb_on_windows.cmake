@@ -44,8 +44,9 @@ else()
     message(FATAL_ERROR "Target architecture not known")
 endif()
 
-target_link_libraries(${PROJECT_NAME} "${LIBUSB_DIR}/${ARCH}/libusb-1.0.lib")
-target_include_directories(${PROJECT_NAME} PRIVATE "${LIBUSB_DIR}" "${LIBUSB_DIR}/libusb-1.0")
+# the usb sources are part of the core library, the application and the benchmarks link it from there
+target_link_libraries(openhantek_core PUBLIC "${LIBUSB_DIR}/${ARCH}/libusb-1.0.lib")
+target_include_directories(openhantek_core PUBLIC "${LIBUSB_DIR}" "${LIBUSB_DIR}/libusb-1.0")
 
 # execute commands
 add_custom_command(TARGET ${PROJECT_NAME}
@@ -0,0 +1,302 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// Headless benchmark of the hot paths from the log line to the vertex arrays and the exporters.
+// Runs the ScopeData parser, the channel store, the resampling, the min/max envelope, the software trigger,
+// the graph and spectrum generation, a complete frame on the ProcessorScheduler and the CSV/JSON exporters
+// on synthetic or recorded data, no widget is created. Every stage is warmed up once and then timed.
+// Usage: openhantek_bench [--lines N] [--channels N] [--samples N] [--frames N] [--log file]
+// Output is one machine readable line per stage:
+// bench=<stage> items=<n> unit=<lines|frames> seconds=.. items_per_s=.. samples_per_s=..
+// allocations=.. allocations_per_item=.. checksum=..
+// A stage that cannot run in this build prints bench=<stage> skipped=<reason> instead.
+
+#include <QBuffer>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "dsosettings.h"
+#include "exporting/exportcsv.h"
+#include "exporting/exporterregistry.h"
+#include "exporting/exportjson.h"
+#include "hantekdso/dsosamples.h"
+#include "hantekdso/triggering.h"
+#include "input/samplesource.h"
+#include "input/scopedataparser.h"
+#include "post/graphgenerator.h"
+#include "post/ppresult.h"
+#include "post/processorscheduler.h"
+#include "post/spectrumgenerator.h"
+
+
+int verboseLevel = 0; // defined by main.cpp in the application
+
+static std::atomic< unsigned long long > allocations( 0 );
+
+void *operator new( size_t size ) {
+    ++allocations;
+    if ( void *p = malloc( size ? size : 1 ) )
+        return p;
+    throw std::bad_alloc();
+}
+
+
+void operator delete( void *p ) noexcept { free( p ); }
+
+
+void operator delete( void *p, size_t ) noexcept { free( p ); }
+
+
+/// \brief Run `step` `calls` times after one warm-up call and print its throughput.
+/// \param items Units (lines or frames) handled by one call.
+/// \param samples Samples handled by one call.
+static void measure( const char *name, const char *unit, size_t calls, size_t items, size_t samples,
+                     const std::function< double() > &step ) {
+    double checksum = step(); // warm-up, fills the pools and caches
+    const unsigned long long startAllocations = allocations;
+    const auto start = std::chrono::steady_clock::now();
+    for ( size_t call = 0; call < calls; ++call )
+        checksum += step();
+    const std::chrono::duration< double > elapsed = std::chrono::steady_clock::now() - start;
+    const unsigned long long used = allocations - startAllocations;
+    const double seconds = std::max( elapsed.count(), 1e-9 );
+    const double total = double( calls * items );
+    printf( "bench=%s items=%.0f unit=%s seconds=%.6f items_per_s=%.1f samples_per_s=%.1f allocations=%llu "
+            "allocations_per_item=%.3f checksum=%.6g\n",
+            name, total, unit, seconds, total / seconds, double( calls * samples ) / seconds, used, double( used ) / total,
+            checksum );
+    fflush( stdout );
+}
+
+
+/// \brief The payloads of the "ScopeData: " lines of a recorded log.
+static std::vector< std::string > readLog( const QString &fileName ) {
+    static const std::string key = "ScopeData: ";
+    std::vector< std::string > lines;
+    std::ifstream log( fileName.toStdString() );
+    std::string line;
+    while ( std::getline( log, line ) ) {
+        const size_t found = line.find( key );
+        if ( found != std::string::npos )
+            lines.push_back( line.substr( found + key.size() ) );
+    }
+    return lines;
+}
+
+
+/// \brief Payloads of a game at 60 frames per second with `channels` timings.
+static std::vector< std::string > syntheticLines( size_t count, unsigned channels ) {
+    std::vector< std::string > lines;
+    lines.reserve( count );
+    srand( 1 );
+    char buffer[ 64 ];
+    for ( size_t i = 0; i < count; ++i ) {
+        snprintf( buffer, sizeof( buffer ), "Time: %.4f", double( i ) / 60.0 );
+        std::string line( buffer );
+        for ( unsigned channel = 0; channel < channels; ++channel ) {
+            snprintf( buffer, sizeof( buffer ), ", Channel%u: %.3f", channel, 8.0 + ( rand() % 16000 ) / 1000.0 );
+            line += buffer;
+        }
+        lines.push_back( std::move( line ) );
+    }
+    return lines;
+}
+
+
+int main( int argc, char *argv[] ) {
+    QCoreApplication application( argc, argv );
+    // DsoSettings keeps its own store, the settings of the application are not touched
+    QCoreApplication::setOrganizationName( "OpenHantekBench" );
+    QCoreApplication::setApplicationName( "openhantek_bench" );
+
+    QCommandLineParser p;
+    p.addHelpOption();
+    QCommandLineOption linesOption( "lines", "Synthetic log lines to parse", "N", "200000" );
+    QCommandLineOption channelsOption( "channels", "Channels per synthetic log line", "N", "16" );
+    QCommandLineOption samplesOption( "samples", "Samples per channel of a frame", "N", "20000" );
+    QCommandLineOption framesOption( "frames", "Frames per frame based stage", "N", "200" );
+    QCommandLineOption logOption( "log", "Parse the ScopeData lines of a recorded log instead of synthetic ones", "File" );
+    p.addOptions( { linesOption, channelsOption, samplesOption, framesOption, logOption } );
+    p.process( application );
+    const size_t samples = std::max< size_t >( p.value( samplesOption ).toULong(), 16 );
+    const size_t frames = std::max< size_t >( p.value( framesOption ).toULong(), 1 );
+
+    //////// Log lines -> channel store ////////
+    const std::vector< std::string > lines = p.isSet( logOption )
+                                                 ? readLog( p.value( logOption ) )
+                                                 : syntheticLines( std::max< size_t >( p.value( linesOption ).toULong(), 1 ),
+                                                                   std::max( p.value( channelsOption ).toUInt(), 1u ) );
+    if ( lines.empty() ) {
+        fprintf( stderr, "no ScopeData lines\n" );
+        return 1;
+    }
+    ScopeDataParser parser;
+    ScopeDataParser::Line parsed;
+    size_t valueCount = 0;
+    for ( const std::string &line : lines ) {
+        parser.parse( line.data(), line.data() + line.size(), parsed );
+        valueCount += parsed.values.size();
+    }
+    measure( "parse", "lines", 5, lines.size(), valueCount, [ & ]() {
+        double checksum = 0.0;
+        for ( const std::string &line : lines ) {
+            parser.parse( line.data(), line.data() + line.size(), parsed );
+            checksum += parsed.time + ( parsed.values.empty() ? 0.0 : parsed.values.back().value );
+        }
+        return checksum;
+    } );
+
+    SampleBlockPool pool;
+    std::vector< std::unique_ptr< SampleData > > store;
+    int64_t timeOffset = 0; // every pass appends after the previous one, the rings stay sorted
+    // parsed again, the values are appended per channel as LogSource does it
+    measure( "append", "lines", 5, lines.size(), valueCount, [ & ]() {
+        int64_t time = 0;
+        for ( const std::string &line : lines ) {
+            parser.parse( line.data(), line.data() + line.size(), parsed );
+            time = timeOffset + int64_t( parsed.time * 1e9 );
+            for ( const ScopeDataParser::Value &value : parsed.values ) {
+                while ( store.size() <= value.channel )
+                    store.emplace_back( new SampleData( &pool ) );
+                store[ value.channel ]->addData( time, value.value );
+            }
+        }
+        timeOffset = time + 1;
+        return double( store.size() );
+    } );
+
+    //////// Frames ////////
+    DsoSettings settings( 2, 0, true ); // default configuration, two channels
+    DsoSettingsScope &scope = settings.scope;
+    const unsigned channels = unsigned( scope.voltage.size() );
+    for ( unsigned channel = 0; channel < channels; ++channel ) {
+        scope.voltage[ channel ].used = true;
+        scope.spectrum[ channel ].used = true;
+    }
+    const double samplerate = 1e5;
+    const double interval = 1e9 / samplerate;
+
+    // time stamped input: a 1 kHz sine per channel, the snapshots span two screens like the ones of DsoInput
+    std::vector< std::unique_ptr< SampleData > > inputs;
+    DSOsamples raw;
+    raw.data.resize( channels );
+    raw.startTime.assign( channels, 0 );
+    raw.samplerate = samplerate;
+    raw.sampleCount = samples;
+    for ( unsigned channel = 0; channel < channels; ++channel ) {
+        inputs.emplace_back( new SampleData( &pool ) );
+        inputs.back()->data.setMaxBlocks( samples / SampleBlock::capacity + 2 );
+        for ( size_t i = 0; i < samples; ++i )
+            inputs.back()->addData( int64_t( double( i ) * interval ),
+                                    std::sin( 2 * M_PI * 1e3 * double( i ) / samplerate + channel ) );
+        inputs.back()->data.snapshot( 0, raw.data[ channel ] );
+    }
+
+    std::vector< Sample > grid;
+    measure( "resample", "frames", frames, 1, samples * channels, [ & ]() {
+        double checksum = 0.0;
+        for ( unsigned channel = 0; channel < channels; ++channel ) {
+            raw.data[ channel ].resample( 0, interval, samples, grid );
+            checksum += double( grid.back() );
+        }
+        return checksum;
+    } );
+
+    // the min/max columns of a 1024 pixel wide screen, read from the pyramids of the blocks
+    const size_t columns = 2048;
+    std::vector< Sample > minima, maxima;
+    measure( "envelope", "frames", frames, 1, samples * channels, [ & ]() {
+        double checksum = 0.0;
+        for ( unsigned channel = 0; channel < channels; ++channel ) {
+            raw.data[ channel ].envelope( 0, interval * double( samples ) / double( columns ), columns, minima, maxima );
+            checksum += double( maxima.back() - minima.back() );
+        }
+        return checksum;
+    } );
+
+    Dso::ControlSettings control( nullptr, channels );
+    control.samplerate.current = samplerate;
+    control.samplerate.target.duration = double( samples ) / samplerate / 2; // the screen shows half the samples
+    control.trigger.source = 0;
+    control.trigger.level[ 0 ] = 0.5;
+    control.trigger.position = 0.5;
+    Triggering triggering( &scope, control );
+    measure( "trigger", "frames", frames, 1, samples, [ & ]() {
+        return double( triggering.searchTriggeredPosition( raw ) );
+    } );
+
+    // the resampled frame as PostProcessing::convertData() builds it
+    std::shared_ptr< PPresult > result = std::make_shared< PPresult >( channels );
+    for ( unsigned channel = 0; channel < channels; ++channel ) {
+        DataChannel *data = result->modifiableData( channel );
+        data->voltage.interval = 1.0 / samplerate;
+        raw.data[ channel ].resample( 0, interval, samples, data->voltage.samples.modify() );
+    }
+
+    SpectrumGenerator spectrumGenerator( &scope, &settings.analysis );
+    Processor *spectrum = &spectrumGenerator;
+    // without FFTW the generator returns before the transform, its figures would be those of a no-op
+    spectrum->process( result.get() );
+    const bool hasSpectrum = !result->data( 0 )->spectrum.samples->empty();
+    if ( hasSpectrum ) {
+        measure( "spectrum", "frames", frames, 1, samples * channels, [ & ]() {
+            spectrum->process( result.get() );
+            return result->data( 0 )->frequency;
+        } );
+    } else {
+        printf( "bench=spectrum skipped=no_fft\n" );
+        fflush( stdout );
+    }
+
+    GraphGenerator graphGenerator( &scope, &settings.view );
+    Processor *graph = &graphGenerator;
+    measure( "graph", "frames", frames, 1, samples * channels, [ & ]() {
+        graph->process( result.get() );
+        return double( result->vaChannelVoltage[ 0 ].size() );
+    } );
+
+    ProcessorScheduler scheduler;
+    std::vector< Processor * > processors{ graph };
+    if ( hasSpectrum )
+        processors.insert( processors.begin(), spectrum );
+    scheduler.setProcessors( processors );
+    measure( hasSpectrum ? "frame" : "frame_without_spectrum", "frames", frames, 1, samples * channels, [ & ]() {
+        scheduler.run( result.get() );
+        return double( result->vaChannelVoltage[ 0 ].size() );
+    } );
+
+    //////// Exporters, into memory ////////
+    ExporterRegistry registry( &settings );
+    ExporterCSV csv;
+    ExporterJSON json;
+    for ( ExporterInterface *exporter : std::initializer_list< ExporterInterface * >{ &csv, &json } ) {
+        exporter->create( &registry );
+        exporter->samples( result );
+    }
+    QBuffer buffer;
+    const size_t exports = std::max( frames / 20, size_t( 1 ) );
+    measure( "export_csv", "frames", exports, 1, samples * channels, [ & ]() {
+        buffer.open( QIODevice::WriteOnly | QIODevice::Truncate );
+        csv.write( &buffer );
+        buffer.close();
+        return double( buffer.size() );
+    } );
+    measure( "export_json", "frames", exports, 1, samples * channels, [ & ]() {
+        buffer.open( QIODevice::WriteOnly | QIODevice::Truncate );
+        json.write( &buffer );
+        buffer.close();
+        return double( buffer.size() );
+    } );
+    return 0;
+}
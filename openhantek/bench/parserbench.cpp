@@ -0,0 +1,223 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// Microbenchmark of the ScopeData line parser.
+// Compares the single pass ScopeDataParser with the former token based LexicalParser()/DataParser()
+// plus QMap channel lookup on synthetic lines. Usage: parserbench [lines] [channels]
+// Output is one machine readable line per parser.
+
+#include <QMap>
+#include <QPair>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "input/scopedataparser.h"
+
+
+static std::atomic< unsigned long long > allocations( 0 );
+
+void *operator new( size_t size ) {
+    ++allocations;
+    if ( void *p = malloc( size ? size : 1 ) )
+        return p;
+    throw std::bad_alloc();
+}
+
+
+void operator delete( void *p ) noexcept { free( p ); }
+
+
+void operator delete( void *p, size_t ) noexcept { free( p ); }
+
+
+// Former parser of input/dsoinput.cpp, kept verbatim as reference
+
+static bool isSep(const QChar& ch)
+{
+    static QSet<QChar> seps = {
+        ':',
+        ',',
+    };
+    return seps.contains(ch);
+}
+
+static bool isDot(const QChar& ch)
+{
+    return ch == '.';
+}
+
+QVector<QString> LexicalParser(const QString& s)
+{
+    QVector<QString> tokens;
+    int startPos = 0;
+    int maxLen = s.size();
+    while(startPos < maxLen)
+    {
+        const QChar ch = s[startPos];
+        if(ch.isSpace())
+        {
+        }
+        else if(ch.isLetter())
+        {
+            int scanPos = startPos + 1;
+            while(scanPos < maxLen && s[scanPos].isLetterOrNumber())
+                ++scanPos;
+            tokens.push_back(s.mid(startPos, scanPos-startPos));
+            startPos = scanPos - 1;
+        }
+        else if(ch.isDigit() || isDot(ch) || ch == '-')
+        {
+            bool hasDot = isDot(ch);
+            int scanPos = startPos + 1;
+            while(scanPos < maxLen)
+            {
+                if(isDot(s[scanPos]))
+                {
+                    if(hasDot)
+                    {
+                        break;
+                    }
+                    hasDot = true;
+                }
+                else if(!s[scanPos].isDigit())
+                {
+                    break;
+                }
+                ++scanPos;
+            }
+            tokens.push_back(s.mid(startPos, scanPos-startPos));
+            startPos = scanPos - 1;
+        }
+        else if(isSep(ch))
+        {
+            tokens.push_back(ch);
+        }
+        ++startPos;
+    }
+    return tokens;
+}
+
+struct AnalysedChannelData
+{
+    float sampleTime;
+    QVector<QPair<QString, float>> datas;
+};
+
+AnalysedChannelData DataParser(const QVector<QString>& tokens)
+{
+    AnalysedChannelData data;
+    bool bOk = false;
+    if (tokens.size() > 2)
+    {
+        data.sampleTime = tokens[2].toFloat(&bOk);
+        if(!bOk)
+            return data;
+    }
+
+    for(int i=4;i+2<tokens.size();i+=4)
+    {
+        float v = tokens[i+2].toFloat(&bOk);
+        if(!bOk)
+            return data;
+        data.datas.push_back(qMakePair(tokens[i], v));
+    }
+    return data;
+}
+
+
+// End of former parser
+
+
+struct Result {
+    double seconds;
+    unsigned long long allocations;
+    double checksum;
+};
+
+
+static Result runLegacy( const std::vector< std::string > &lines ) {
+    QMap< QString, int > channels;
+    double checksum = 0.0;
+    const unsigned long long startAllocations = allocations;
+    const auto start = std::chrono::steady_clock::now();
+    for ( const std::string &line : lines ) {
+        QString lineStr = QString::fromUtf8( line.data(), int( line.size() ) ).trimmed();
+        QVector< QString > tokens = LexicalParser( lineStr );
+        AnalysedChannelData data = DataParser( tokens );
+        checksum += data.sampleTime;
+        for ( const auto &pair : data.datas ) {
+            auto it = channels.find( pair.first );
+            if ( it == channels.end() )
+                it = channels.insert( pair.first, channels.size() );
+            checksum += pair.second + it.value();
+        }
+    }
+    const std::chrono::duration< double > elapsed = std::chrono::steady_clock::now() - start;
+    return { elapsed.count(), allocations - startAllocations, checksum };
+}
+
+
+static Result runScopeDataParser( const std::vector< std::string > &lines ) {
+    ScopeDataParser parser;
+    ScopeDataParser::Line parsed;
+    double checksum = 0.0;
+    const unsigned long long startAllocations = allocations;
+    const auto start = std::chrono::steady_clock::now();
+    for ( const std::string &line : lines ) {
+        parser.parse( line.data(), line.data() + line.size(), parsed );
+        checksum += float( parsed.time );
+        for ( const ScopeDataParser::Value &value : parsed.values )
+            checksum += float( value.value ) + value.channel;
+    }
+    const std::chrono::duration< double > elapsed = std::chrono::steady_clock::now() - start;
+    return { elapsed.count(), allocations - startAllocations, checksum };
+}
+
+
+static void report( const char *name, const Result &result, size_t lines, size_t bytes ) {
+    printf( "parser=%s lines=%zu ns_per_line=%.1f mbytes_per_s=%.1f allocations=%llu allocations_per_line=%.3f checksum=%.6g\n",
+            name, lines, result.seconds * 1e9 / double( lines ), double( bytes ) / result.seconds / 1e6, result.allocations,
+            double( result.allocations ) / double( lines ), result.checksum );
+}
+
+
+int main( int argc, char *argv[] ) {
+    const size_t lineCount = argc > 1 ? size_t( atol( argv[ 1 ] ) ) : 200000;
+    const unsigned channelCount = argc > 2 ? unsigned( atoi( argv[ 2 ] ) ) : 16;
+    if ( !lineCount || !channelCount ) {
+        fprintf( stderr, "usage: %s [lines] [channels]\n", argv[ 0 ] );
+        return 1;
+    }
+
+    // payload of "ScopeData: " lines, channel names are letters and digits only as the former lexer requires
+    std::vector< std::string > lines;
+    lines.reserve( lineCount );
+    size_t bytes = 0;
+    srand( 1 );
+    char buffer[ 64 ];
+    for ( size_t i = 0; i < lineCount; ++i ) {
+        snprintf( buffer, sizeof( buffer ), "Time: %.3f", double( i ) / 60.0 );
+        std::string line( buffer );
+        for ( unsigned channel = 0; channel < channelCount; ++channel ) {
+            snprintf( buffer, sizeof( buffer ), ", Channel%u: %.3f", channel, ( rand() % 200000 - 100000 ) / 1000.0 );
+            line += buffer;
+        }
+        bytes += line.size();
+        lines.push_back( std::move( line ) );
+    }
+
+    const Result legacy = runLegacy( lines );
+    report( "legacy", legacy, lineCount, bytes );
+    const Result single = runScopeDataParser( lines );
+    report( "scopedata", single, lineCount, bytes );
+    printf( "speedup=%.2f\n", legacy.seconds / single.seconds );
+    return 0;
+}
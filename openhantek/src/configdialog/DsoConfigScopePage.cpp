@@ -36,7 +36,7 @@ DsoConfigScopePage::DsoConfigScopePage( DsoSettings *settings, QWidget *parent )
     digitalPhosphorDepthLabel = new QLabel( tr( "Digital phosphor depth" ) );
     digitalPhosphorDepthSpinBox = new QSpinBox();
     digitalPhosphorDepthSpinBox->setMinimum( 2 );
-    digitalPhosphorDepthSpinBox->setMaximum( 99 );
+    digitalPhosphorDepthSpinBox->setMaximum( 999 ); // no extra drawing, the 16 bit phosphor fades over 999 frames
     digitalPhosphorDepthSpinBox->setValue( int( settings->view.digitalPhosphorDepth ) );
     interpolationLabel = new QLabel( tr( "Interpolation" ) );
     interpolationComboBox = new QComboBox();
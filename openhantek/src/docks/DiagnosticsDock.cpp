@@ -0,0 +1,125 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <QCloseEvent>
+#include <QDebug>
+#include <QLabel>
+#include <QPushButton>
+#include <QTimer>
+
+#include "DiagnosticsDock.h"
+#include "dockwindows.h"
+
+#include "input/framemailbox.h"
+#include "renderscheduler.h"
+#include "utils/frametrace.h"
+
+
+DiagnosticsDock::DiagnosticsDock( DsoSettingsScope *scope, const FrameMailbox *mailbox, const RenderScheduler *renderScheduler,
+                                  QWidget *parent )
+    : QDockWidget( tr( "Diagnostics" ), parent ), scope( scope ), mailbox( mailbox ), renderScheduler( renderScheduler ) {
+
+    if ( scope->verboseLevel > 1 )
+        qDebug() << " DiagnosticsDock::DiagnosticsDock()";
+
+    dockLayout = new QGridLayout();
+    dockLayout->setColumnMinimumWidth( 0, 64 );
+    dockLayout->setColumnStretch( 0, 1 );
+    dockLayout->setSpacing( DOCK_LAYOUT_SPACING );
+
+    // rows 0 and 1: frame counters, display rate and the reset button, row 2: column titles, then one row per stage
+    framesLabel = new QLabel();
+    dockLayout->addWidget( framesLabel, 0, 0, 1, 5 );
+    displayLabel = new QLabel();
+    dockLayout->addWidget( displayLabel, 1, 0, 1, 4 );
+    QPushButton *resetButton = new QPushButton( tr( "Reset" ) );
+    if ( scope->toolTipVisible )
+        resetButton->setToolTip( tr( "Clear the latency histograms" ) );
+    dockLayout->addWidget( resetButton, 1, 4 );
+    const QStringList titles = { tr( "Stage" ), tr( "Count" ), tr( "p50/ms" ), tr( "p99/ms" ), tr( "max/ms" ) };
+    for ( int column = 0; column < titles.size(); ++column )
+        dockLayout->addWidget( new QLabel( "<b>" + titles[ column ] + "</b>" ), 2, column,
+                               column ? Qt::AlignRight : Qt::AlignLeft );
+
+    connect( resetButton, &QPushButton::clicked, [ this ]() {
+        FrameTrace::instance().reset();
+        refresh();
+    } );
+
+    refreshTimer = new QTimer( this );
+    refreshTimer->setInterval( 1000 );
+    connect( refreshTimer, &QTimer::timeout, this, &DiagnosticsDock::refresh );
+
+    dockWidget = new QWidget();
+    SetupDockWidget( this, dockWidget, dockLayout );
+    refresh();
+}
+
+
+void DiagnosticsDock::refresh() {
+    const std::vector< FrameTrace::Histogram > histograms = FrameTrace::instance().histograms();
+    while ( stageRows.size() < histograms.size() ) {
+        const int row = int( stageRows.size() ) + 3;
+        StageRow labels = { new QLabel( histograms[ stageRows.size() ].name ), new QLabel(), new QLabel(), new QLabel(),
+                            new QLabel() };
+        dockLayout->addWidget( labels.name, row, 0 );
+        int column = 0;
+        for ( QLabel *label : { labels.count, labels.median, labels.p99, labels.max } )
+            dockLayout->addWidget( label, row, ++column, Qt::AlignRight );
+        stageRows.push_back( labels );
+    }
+    const auto ms = []( int64_t ns ) { return QString::number( double( ns ) * 1e-6, 'f', 2 ); };
+    for ( size_t stage = 0; stage < histograms.size(); ++stage ) {
+        const FrameTrace::Histogram &histogram = histograms[ stage ];
+        StageRow &labels = stageRows[ stage ];
+        labels.count->setText( QString::number( histogram.count ) );
+        labels.median->setText( ms( histogram.quantile( 0.5 ) ) );
+        labels.p99->setText( ms( histogram.quantile( 0.99 ) ) );
+        labels.max->setText( ms( histogram.max ) );
+    }
+    if ( mailbox ) {
+        const FrameMailbox::Statistics frames = mailbox->statistics();
+        framesLabel->setText( tr( "Frames: %1 posted, %2 processed, %3 coalesced, %4 dropped" )
+                                  .arg( frames.posted )
+                                  .arg( frames.delivered )
+                                  .arg( frames.coalesced )
+                                  .arg( frames.dropped ) );
+    }
+    if ( renderScheduler ) { // skipped: never drawn, coalesced or dropped in the mailbox
+        const RenderScheduler::Statistics display = renderScheduler->statistics();
+        uint64_t skipped = 0;
+        if ( mailbox ) {
+            const FrameMailbox::Statistics frames = mailbox->statistics();
+            skipped += frames.coalesced + frames.dropped;
+        }
+        double paint = 0.0; // mean, ms
+        for ( const FrameTrace::Histogram &histogram : histograms )
+            if ( histogram.count && QString( histogram.name ) == "paint" )
+                paint = double( histogram.sum ) * 1e-6 / double( histogram.count );
+        displayLabel->setText( tr( "Display: %1 fps, %2 shown, %3 skipped, paint %4 ms" )
+                                   .arg( display.fps, 0, 'f', 1 )
+                                   .arg( display.shown )
+                                   .arg( skipped )
+                                   .arg( paint, 0, 'f', 2 ) );
+    }
+}
+
+
+/// \brief Don't close the dock, just hide it
+/// \param event The close event that should be handled.
+void DiagnosticsDock::closeEvent( QCloseEvent *event ) {
+    hide();
+    event->accept();
+}
+
+
+void DiagnosticsDock::showEvent( QShowEvent *event ) {
+    QDockWidget::showEvent( event );
+    refresh();
+    refreshTimer->start();
+}
+
+
+void DiagnosticsDock::hideEvent( QHideEvent *event ) {
+    refreshTimer->stop();
+    QDockWidget::hideEvent( event );
+}
@@ -0,0 +1,57 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <QDockWidget>
+#include <QGridLayout>
+
+#include "scopesettings.h"
+
+class QLabel;
+class QTimer;
+
+class FrameMailbox;
+class RenderScheduler;
+
+/// \brief Dock window with the latency of the acquisition-to-pixel pipeline.
+/// It shows the quantiles of every stage of the FrameTrace, the frame counters of the mailbox and the frame rate
+/// of the display, refreshed once per second while it is visible.
+class DiagnosticsDock : public QDockWidget {
+    Q_OBJECT
+
+  public:
+    /// \brief Initializes the diagnostics docking window.
+    /// \param mailbox The frame hand over of the input, may be nullptr.
+    /// \param renderScheduler The pacing of the display, may be nullptr.
+    /// \param parent The parent widget.
+    DiagnosticsDock( DsoSettingsScope *scope, const FrameMailbox *mailbox, const RenderScheduler *renderScheduler,
+                     QWidget *parent );
+
+  public slots:
+    /// \brief Read the current histograms and counters into the labels.
+    void refresh();
+
+  protected:
+    void closeEvent( QCloseEvent *event ) override;
+    void showEvent( QShowEvent *event ) override;
+    void hideEvent( QHideEvent *event ) override;
+
+    QGridLayout *dockLayout; ///< The main layout for the dock window
+    QWidget *dockWidget;     ///< The main widget for the dock window
+
+    struct StageRow {
+        QLabel *name;
+        QLabel *count;
+        QLabel *median;
+        QLabel *p99;
+        QLabel *max;
+    };
+    std::vector< StageRow > stageRows; ///< Grows with the stages registered in the FrameTrace
+    QLabel *framesLabel;               ///< Counters of the mailbox
+    QLabel *displayLabel;              ///< Frame rate of the display
+
+    DsoSettingsScope *scope;
+    const FrameMailbox *mailbox;
+    const RenderScheduler *renderScheduler;
+    QTimer *refreshTimer;
+};
@@ -116,7 +116,10 @@ VoltageDock::VoltageDock( DsoSettingsScope *scope, QWidget *parent )
                  [ this, channel, scope ]( int index ) {
                      this->scope->voltage[ channel ].couplingOrMathIndex = index;
                      if(index >= 0)
+                     {
                         this->scope->voltage[channel].selectedChannelName = this->scope->AvaliableChannelNames[index];
+                        emit selectedChannelChanged( channel );
+                     }
 //                     if ( channel < scope->maxChannels ) { // CH1 & CH2
 //                         // setCoupling(channel, (unsigned)index);
 //                         emit couplingChanged( channel, scope->coupling( channel, nullptr ) );
@@ -96,6 +96,7 @@ class VoltageDock : public QDockWidget {
     void gainChanged( ChannelID channel, double gain );                ///< A gain has been selected
     void modeChanged( Dso::MathMode mode );                            ///< The mode for the math channels has been changed
     void usedChannelChanged( ChannelID channel, unsigned used );       ///< A channel has been enabled/disabled
+    void selectedChannelChanged( ChannelID channel );                  ///< Another input channel has been selected
     void probeAttnChanged( ChannelID channel, double probeAttn );      ///< A channel probe attenuation has been changed
     void invertedChanged( ChannelID channel, bool inverted );          ///< A channel "inverted" has been toggled
 };
@@ -158,6 +158,27 @@ void DsoSettings::load() {
     if ( storeSettings->contains( "smooth" ) )
         scope.trigger.smooth = storeSettings->value( "smooth" ).toInt();
     storeSettings->endGroup(); // trigger
+    // Input channel store
+    storeSettings->beginGroup( "input" );
+    if ( storeSettings->contains( "logFiles" ) )
+        scope.input.logFiles = storeSettings->value( "logFiles" ).toStringList();
+    if ( storeSettings->contains( "streams" ) )
+        scope.input.streams = storeSettings->value( "streams" ).toStringList();
+    if ( storeSettings->contains( "logCache" ) )
+        scope.input.logCache = storeSettings->value( "logCache" ).toBool();
+    if ( storeSettings->contains( "subscriptions" ) )
+        scope.input.subscriptions = storeSettings->value( "subscriptions" ).toStringList();
+    if ( storeSettings->contains( "backfillOnSubscribe" ) )
+        scope.input.backfillOnSubscribe = storeSettings->value( "backfillOnSubscribe" ).toBool();
+    if ( storeSettings->contains( "retentionTime" ) )
+        scope.input.retentionTime = storeSettings->value( "retentionTime" ).toDouble();
+    if ( storeSettings->contains( "retentionSamples" ) )
+        scope.input.retentionSamples = storeSettings->value( "retentionSamples" ).toUInt();
+    if ( storeSettings->contains( "memoryBudget" ) )
+        scope.input.memoryBudget = storeSettings->value( "memoryBudget" ).toUInt();
+    if ( storeSettings->contains( "frameSlots" ) )
+        scope.input.frameSlots = storeSettings->value( "frameSlots" ).toUInt();
+    storeSettings->endGroup(); // input
     // Spectrum
     for ( ChannelID channel = 0; channel < scope.spectrum.size(); ++channel ) {
         storeSettings->beginGroup( QString( "spectrum%1" ).arg( channel ) );
@@ -386,6 +407,18 @@ void DsoSettings::save() {
     storeSettings->setValue( "source", scope.trigger.source );
     storeSettings->setValue( "smooth", scope.trigger.smooth );
     storeSettings->endGroup(); // trigger
+    // Input channel store
+    storeSettings->beginGroup( "input" );
+    storeSettings->setValue( "logFiles", scope.input.logFiles );
+    storeSettings->setValue( "streams", scope.input.streams );
+    storeSettings->setValue( "logCache", scope.input.logCache );
+    storeSettings->setValue( "subscriptions", scope.input.subscriptions );
+    storeSettings->setValue( "backfillOnSubscribe", scope.input.backfillOnSubscribe );
+    storeSettings->setValue( "retentionTime", scope.input.retentionTime );
+    storeSettings->setValue( "retentionSamples", scope.input.retentionSamples );
+    storeSettings->setValue( "memoryBudget", scope.input.memoryBudget );
+    storeSettings->setValue( "frameSlots", scope.input.frameSlots );
+    storeSettings->endGroup(); // input
     // Spectrum
     for ( ChannelID channel = 0; channel < scope.spectrum.size(); ++channel ) {
         storeSettings->beginGroup( QString( "spectrum%1" ).arg( channel ) );
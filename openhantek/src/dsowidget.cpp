@@ -32,6 +32,8 @@ DsoWidget::DsoWidget( DsoSettingsScope *scope, DsoSettingsView *view, QWidget *p
     if ( scope->verboseLevel > 1 )
         qDebug() << " DsoWidget::DsoWidget()";
 
+    zoomScope->shareGraphsWith( mainScope ); // a frame is uploaded to the GPU once for both scopes
+
     // get the primary screen size for further use - e.g. graphgenerator.cpp
     QSize screenSize = QGuiApplication::primaryScreen()->size();
     view->screenHeight = unsigned( screenSize.height() );
@@ -57,6 +59,10 @@ DsoWidget::DsoWidget( DsoSettingsScope *scope, DsoSettingsView *view, QWidget *p
         zoomScope->updateCursor( cursorIndex );
     } );
 
+    // the render scheduler hands over the next frame only when the last one is on the screen
+    connect( mainScope, &QOpenGLWidget::frameSwapped, this, &DsoWidget::framePresented );
+    connect( zoomScope, &QOpenGLWidget::frameSwapped, this, &DsoWidget::framePresented );
+
     // do cursor measurement when right button pressed/moved _inside_ window borders
     connect( mainScope, &GlScope::cursorMeasurement, [ this ]( QPointF mPos, QPoint gPos, bool status ) {
         cursorMeasurementPosition = mPos;
@@ -167,4 +167,5 @@ class DsoWidget : public QWidget {
     void voltageOffsetChanged( ChannelID channel, double value ); ///< A graph offset has been changed
     void triggerPositionChanged( double value );                  ///< The pretrigger has been changed
     void triggerLevelChanged( ChannelID channel, double value );  ///< A trigger level has been changed
+    void framePresented(); ///< A scope has swapped a painted frame to the screen, see RenderScheduler
 };
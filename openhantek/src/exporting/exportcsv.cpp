@@ -108,7 +108,16 @@ bool ExporterCSV::save() {
     if ( file == nullptr )
         return false;
 
-    QTextStream csvStream( file );
+    write( file );
+
+    file->close();
+    delete file;
+
+    return true;
+}
+
+void ExporterCSV::write( QIODevice *device ) {
+    QTextStream csvStream( device );
     csvStream.setRealNumberNotation( QTextStream::FixedNotation );
     csvStream.setRealNumberPrecision( 10 );
 
@@ -119,11 +128,6 @@ bool ExporterCSV::save() {
 
     fillHeaders( csvStream, dto, sep );
     fillData( csvStream, dto, sep );
-
-    file->close();
-    delete file;
-
-    return true;
 }
 
 
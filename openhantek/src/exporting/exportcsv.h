@@ -20,6 +20,8 @@ class ExporterCSV : public ExporterInterface {
     bool samples( const std::shared_ptr< PPresult > newData ) override;
     bool save() override;
     float progress() override;
+    /// \brief Write the received samples to the opened `device`, save() asks for the file.
+    void write( QIODevice *device );
 
   private:
     QFile *getFile();
@@ -10,6 +10,9 @@ class ExporterProcessor : public Processor {
   public:
     explicit ExporterProcessor( ExporterRegistry *registry );
     void process( PPresult * ) override;
+    Products inputs() const override { return Samples; }
+    const char *name() const override { return "export tap"; }
+    Products outputs() const override { return ExportTap; }
 
   private:
     ExporterRegistry *registry;
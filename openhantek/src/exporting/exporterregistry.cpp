@@ -24,7 +24,7 @@ bool ExporterRegistry::processData( std::shared_ptr< PPresult > &data, ExporterI
 void ExporterRegistry::addRawSamples( PPresult *d ) {
     if ( settings->exportProcessedSamples )
         return;
-    std::shared_ptr< PPresult > data( d );
+    std::shared_ptr< PPresult > data = d->shared_from_this(); // owned by the post processing
     enabledExporters.remove_if( [ &data, this ]( ExporterInterface *const &i ) { return processData( data, i ); } );
 }
 
@@ -101,12 +101,7 @@ bool ExporterJSON::save() {
     if ( jsonFile == nullptr )
         return false;
 
-    QTextStream jsonStream( jsonFile );
-    jsonStream.setRealNumberNotation( QTextStream::FixedNotation );
-    jsonStream.setRealNumberPrecision( 10 );
-
-    ExporterData dto = ExporterData( data, registry->settings->scope );
-    fillData( jsonStream, dto );
+    write( jsonFile );
 
     jsonFile->close();
     delete jsonFile;
@@ -114,5 +109,14 @@ bool ExporterJSON::save() {
     return true;
 }
 
+void ExporterJSON::write( QIODevice *device ) {
+    QTextStream jsonStream( device );
+    jsonStream.setRealNumberNotation( QTextStream::FixedNotation );
+    jsonStream.setRealNumberPrecision( 10 );
+
+    ExporterData dto = ExporterData( data, registry->settings->scope );
+    fillData( jsonStream, dto );
+}
+
 
 float ExporterJSON::progress() { return data ? 1.0f : 0; }
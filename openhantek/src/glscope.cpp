@@ -64,7 +64,9 @@ void GlScope::useOpenGLSLversion( QString renderer ) {
 
 
 GlScope::GlScope( DsoSettingsScope *scope, DsoSettingsView *view, QWidget *parent )
-    : QOpenGLWidget( parent ), scope( scope ), view( view ) {
+    : QOpenGLWidget( parent ), scope( scope ), view( view ), graphBuffer( std::make_shared< GraphBuffer >() ),
+      writeStage( FrameTrace::instance().stage( "write data" ) ),
+      paintStage( FrameTrace::instance().stage( "paint" ) ), endToEndStage( FrameTrace::instance().stage( "end to end" ) ) {
     if ( scope->verboseLevel > 1 )
         qDebug() << " GLScope::GLScope()";
     cursorInfo.clear();
@@ -83,6 +85,19 @@ GlScope::GlScope( DsoSettingsScope *scope, DsoSettingsView *view, QWidget *paren
 GlScope::~GlScope() { // virtual destructor necessary
     if ( scope->verboseLevel > 1 )
         qDebug() << " GLScope::~GLScope()";
+    // the GL objects of the members are released in the context of this scope, it is not current otherwise
+    makeCurrent();
+    phosphor.destroy();
+    rollGraph.destroy();
+    m_Graph.destroy();
+    graphBuffer.reset(); // the last scope that shows the frame releases its buffer
+    for ( auto &vao : m_vaoGrid )
+        vao.destroy();
+    m_grid.destroy();
+    m_vaoMarker.destroy();
+    m_marker.destroy();
+    m_program.reset();
+    doneCurrent();
 }
 
 
@@ -378,9 +393,11 @@ void GlScope::initializeGL() {
           #version 150
           in highp vec3 vertex;
           uniform mat4 matrix;
+          uniform highp vec3 grid; // x0, dx, repeat of a trace that holds only y, repeat 0: complete vertices
           void main()
           {
-              gl_Position = matrix * vec4(vertex, 1.0);
+              vec3 position = grid.z > 0.0 ? vec3(grid.x + float(gl_VertexID / int(grid.z)) * grid.y, vertex.x, 0.0) : vertex;
+              gl_Position = matrix * vec4(position, 1.0);
               gl_PointSize = 1.0;
           }
     )";
@@ -445,12 +462,17 @@ void GlScope::initializeGL() {
     vertexLocation = program->attributeLocation( "vertex" );
     matrixLocation = program->uniformLocation( "matrix" );
     colorLocation = program->uniformLocation( "color" );
+    gridLocation = program->uniformLocation( "grid" ); // only GLSL 1.50 has gl_VertexID, else -1
 
     if ( vertexLocation == -1 || colorLocation == -1 || matrixLocation == -1 ) {
         qWarning() << tr( "Failed to locate shader variable." );
         return;
     }
 
+    QString phosphorLog;
+    if ( !phosphor.create( GLSLversion, phosphorLog ) ) // the traces are drawn without persistence
+        qWarning() << "Digital phosphor not available:" << phosphorLog;
+
     program->bind();
 
     auto *gl = context()->functions();
@@ -489,20 +511,21 @@ void GlScope::showData( std::shared_ptr< PPresult > newData ) {
     if ( !shaderCompileSuccess )
         return;
     makeCurrent();
-    // Remove too much entries
-    while ( view->digitalPhosphorDraws() < m_GraphHistory.size() )
-        m_GraphHistory.pop_back();
-
-    // Add if missing
-    if ( view->digitalPhosphorDraws() > m_GraphHistory.size() ) {
-        m_GraphHistory.resize( m_GraphHistory.size() + 1 );
-    }
-
-    // Move last item to front
-    m_GraphHistory.splice( m_GraphHistory.begin(), m_GraphHistory, std::prev( m_GraphHistory.end() ) );
 
-    // Add new entry
-    m_GraphHistory.front().writeData( newData.get(), m_program.get(), vertexLocation );
+    // Replace the traces, the previous ones live on in the phosphor
+    const int64_t begin = FrameTrace::now();
+    graphBuffer->writeData( newData, gridLocation != -1 ); // once for all scopes that share it
+    m_Graph.bind( *graphBuffer, m_program.get(), vertexLocation );
+    if ( view->digitalPhosphor )
+        ++phosphorFrames;
+    rolling = newData->rolling;
+    if ( rolling ) // only the new samples are uploaded
+        rollGraph.writeData( newData.get(), scope, m_program.get(), vertexLocation );
+    else
+        rollGraph.clear();
+    FrameTrace::instance().span( writeStage, begin, FrameTrace::now(), newData->tag );
+    shownTag = newData->tag;
+    shownStamps = newData->stamps;
     // doneCurrent();
 
     update();
@@ -569,6 +592,7 @@ void GlScope::updateCursor( int index ) {
 void GlScope::paintGL() {
     if ( !shaderCompileSuccess )
         return;
+    const int64_t begin = FrameTrace::now();
 
     auto *gl = context()->functions();
 
@@ -576,34 +600,46 @@ void GlScope::paintGL() {
     gl->glClearColor( GLfloat( bg.redF() ), GLfloat( bg.greenF() ), GLfloat( bg.blueF() ), GLfloat( bg.alphaF() ) );
 
     // Clear OpenGL buffer and configure settings
-    // TODO Don't clear if view->digitalPhosphorDraws()>1
     gl->glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
     gl->glLineWidth( 1 );
 
     m_program->bind();
+    setGridUniform( QVector3D() );
 
     // Apply zoom settings via matrix transformation
+    QMatrix4x4 graphMatrix = pmvMatrix;
     if ( zoomed ) {
-        QMatrix4x4 m;
-        m.scale( QVector3D( GLfloat( DIVS_TIME ) / GLfloat( fabs( scope->getMarker( 1 ) - scope->getMarker( 0 ) ) ), 1.0f, 1.0f ) );
-        m.translate( -GLfloat( scope->getMarker( 0 ) + scope->getMarker( 1 ) ) / 2, 0.0f, 0.0f );
-        m_program->setUniformValue( matrixLocation, pmvMatrix * m );
+        graphMatrix.scale(
+            QVector3D( GLfloat( DIVS_TIME ) / GLfloat( fabs( scope->getMarker( 1 ) - scope->getMarker( 0 ) ) ), 1.0f, 1.0f ) );
+        graphMatrix.translate( -GLfloat( scope->getMarker( 0 ) + scope->getMarker( 1 ) ) / 2, 0.0f, 0.0f );
+        m_program->setUniformValue( matrixLocation, graphMatrix );
     }
 
     drawMarkers();
 
-    unsigned historyIndex = 0;
-    for ( Graph &graph : m_GraphHistory ) {
-        for ( ChannelID channel = 0; channel < scope->voltage.size(); ++channel ) {
-            if ( scope->horizontal.format == Dso::GraphFormat::TY ) {
-                drawSpectrumChannelGraph( channel, graph, int( historyIndex ) );
-                if ( scope->histogram ) {
-                    drawHistogramChannelGraph( channel, graph, int( historyIndex ) );
-                }
-            }
-            drawVoltageChannelGraph( channel, graph, int( historyIndex ) );
+    if ( view->digitalPhosphor && phosphor.isCreated() ) {
+        if ( m_Graph.isBound() && phosphorFrames ) { // fade the older traces and add the new ones
+            // a trace fades to 10 % within digitalPhosphorDepth frames
+            const double decay = std::pow( 0.1, double( phosphorFrames ) / std::max( view->digitalPhosphorDepth, 1u ) );
+            phosphor.beginFrame( gl, float( decay ) );
+            m_program->bind();
+            drawGraph( m_Graph );
+            phosphor.endFrame( gl, defaultFramebufferObject() );
+            phosphorFrames = 0;
         }
-        ++historyIndex;
+        phosphor.composite( gl );
+        m_program->bind();
+    } else {
+        phosphor.clear();
+        phosphorFrames = 0;
+        if ( m_Graph.isBound() )
+            drawGraph( m_Graph );
+    }
+    setGridUniform( QVector3D() ); // the roll mode, markers and grid have complete vertices
+    if ( rolling ) {
+        for ( ChannelID channel = 0; channel < scope->voltage.size(); ++channel )
+            drawRollChannelGraph( channel, graphMatrix );
+        m_program->setUniformValue( matrixLocation, graphMatrix );
     }
 
     if ( zoomed ) {
@@ -612,6 +648,16 @@ void GlScope::paintGL() {
 
     drawGrid();
     m_program->release();
+
+    // the commands are queued, the driver may still work on them, but a slow frame shows up here already
+    const int64_t end = FrameTrace::now();
+    FrameTrace &trace = FrameTrace::instance();
+    trace.span( paintStage, begin, end, shownTag );
+    static unsigned paintedTag = 0; // shared by all scopes (GUI thread), a frame counts once from its first paint
+    if ( shownTag != paintedTag && shownStamps.read ) {
+        paintedTag = shownTag;
+        trace.span( endToEndStage, shownStamps.read, end, shownTag );
+    }
 }
 
 
@@ -878,40 +924,75 @@ void GlScope::drawMarkers() {
 }
 
 
-void GlScope::drawVoltageChannelGraph( ChannelID channel, Graph &graph, int historyIndex ) {
+void GlScope::drawGraph( Graph &graph ) {
+    for ( ChannelID channel = 0; channel < scope->voltage.size(); ++channel ) {
+        if ( scope->horizontal.format == Dso::GraphFormat::TY ) {
+            drawSpectrumChannelGraph( channel, graph );
+            if ( scope->histogram ) {
+                drawHistogramChannelGraph( channel, graph );
+            }
+        }
+        drawVoltageChannelGraph( channel, graph );
+    }
+}
+
+
+void GlScope::drawVoltageChannelGraph( ChannelID channel, Graph &graph ) {
     if ( !scope->voltage[ channel ].used )
         return;
 
-    m_program->setUniformValue( colorLocation, view->colors->voltage[ channel ].darker( 100 + 10 * historyIndex ) );
-    Graph::VaoCount &v = graph.vaoVoltage[ channel ];
+    m_program->setUniformValue( colorLocation, view->colors->voltage[ channel ] );
+    // the zoom scope has its own trace between the markers, at its resolution, unless the frame has none
+    const bool zoomTrace = zoomed && channel < graph.vaoZoom.size() && graph.vaoZoom[ channel ].count;
+    const Graph::VaoCount &v = zoomTrace ? graph.vaoZoom[ channel ] : graph.vaoVoltage[ channel ];
 
-    QOpenGLVertexArrayObject::Binder b( v.first );
+    setGridUniform( v.grid );
+    QOpenGLVertexArrayObject::Binder b( v.vao );
     const GLenum dMode = ( view->interpolation == Dso::INTERPOLATION_OFF ) ? GL_POINTS : GL_LINE_STRIP;
-    context()->functions()->glDrawArrays( dMode, 0, v.second );
+    context()->functions()->glDrawArrays( dMode, 0, v.count );
 }
 
 
-void GlScope::drawHistogramChannelGraph( ChannelID channel, Graph &graph, int historyIndex ) {
+void GlScope::drawHistogramChannelGraph( ChannelID channel, Graph &graph ) {
     if ( graph.vaoHistogram.empty() || !scope->voltage[ channel ].used )
         return;
 
-    m_program->setUniformValue( colorLocation, view->colors->voltage[ channel ].darker( 100 + 10 * historyIndex ) );
-    Graph::VaoCount &h = graph.vaoHistogram[ channel ];
+    m_program->setUniformValue( colorLocation, view->colors->voltage[ channel ] );
+    const Graph::VaoCount &h = graph.vaoHistogram[ channel ];
 
-    QOpenGLVertexArrayObject::Binder b( h.first );
+    setGridUniform( h.grid );
+    QOpenGLVertexArrayObject::Binder b( h.vao );
     const GLenum dMode = GL_LINES; // display histogram with lines
-    context()->functions()->glDrawArrays( dMode, 0, h.second );
+    context()->functions()->glDrawArrays( dMode, 0, h.count );
 }
 
 
-void GlScope::drawSpectrumChannelGraph( ChannelID channel, Graph &graph, int historyIndex ) {
+void GlScope::drawSpectrumChannelGraph( ChannelID channel, Graph &graph ) {
     if ( !scope->spectrum[ channel ].used )
         return;
 
-    m_program->setUniformValue( colorLocation, view->colors->spectrum[ channel ].darker( 100 + 10 * historyIndex ) );
-    Graph::VaoCount &v = graph.vaoSpectrum[ channel ];
+    m_program->setUniformValue( colorLocation, view->colors->spectrum[ channel ] );
+    const Graph::VaoCount &v = graph.vaoSpectrum[ channel ];
+
+    setGridUniform( v.grid );
+    QOpenGLVertexArrayObject::Binder b( v.vao );
+    const GLenum dMode = ( view->interpolation == Dso::INTERPOLATION_OFF ) ? GL_POINTS : GL_LINE_STRIP;
+    context()->functions()->glDrawArrays( dMode, 0, v.count );
+}
+
+
+void GlScope::setGridUniform( const QVector3D &grid ) {
+    if ( gridLocation != -1 )
+        m_program->setUniformValue( gridLocation, grid );
+}
+
+
+void GlScope::drawRollChannelGraph( ChannelID channel, const QMatrix4x4 &graphMatrix ) {
+    if ( !scope->voltage[ channel ].used )
+        return;
 
-    QOpenGLVertexArrayObject::Binder b( v.first );
+    m_program->setUniformValue( colorLocation, view->colors->voltage[ channel ] );
+    m_program->setUniformValue( matrixLocation, graphMatrix * rollGraph.transform( channel ) ); // scrolls the ring
     const GLenum dMode = ( view->interpolation == Dso::INTERPOLATION_OFF ) ? GL_POINTS : GL_LINE_STRIP;
-    context()->functions()->glDrawArrays( dMode, 0, v.second );
+    rollGraph.draw( channel, context()->functions(), dMode );
 }
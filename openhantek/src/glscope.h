@@ -2,7 +2,6 @@
 
 #pragma once
 
-#include <list>
 #include <memory>
 
 #include <QOpenGLBuffer>
@@ -13,8 +12,11 @@
 #include <QtGlobal>
 
 #include "glscopegraph.h"
+#include "glscopephosphor.h"
+#include "glscoperollgraph.h"
 #include "hantekdso/enums.h"
 #include "hantekprotocol/types.h"
+#include "utils/frametrace.h"
 
 struct DsoSettingsView;
 struct DsoSettingsScope;
@@ -41,6 +43,8 @@ class GlScope : public QOpenGLWidget {
      * @param data
      */
     void showData( std::shared_ptr< PPresult > newData );
+    /// \brief Use the GPU buffer of `other`, a frame shown by both scopes is uploaded only once.
+    void shareGraphsWith( const GlScope *other ) { graphBuffer = other->graphBuffer; }
     void selectCursor( int index );
     void updateCursor( int index = 0 );
     void generateGrid( int index = -1, double value = 0.0, bool pressed = false );
@@ -79,9 +83,14 @@ class GlScope : public QOpenGLWidget {
     void generateVertices( int marker, const DsoSettingsScopeCursor &cursor );
     void drawVertices( QOpenGLFunctions *gl, int marker, QColor color );
 
-    void drawVoltageChannelGraph( ChannelID channel, Graph &graph, int historyIndex );
-    void drawHistogramChannelGraph( ChannelID channel, Graph &graph, int historyIndex );
-    void drawSpectrumChannelGraph( ChannelID channel, Graph &graph, int historyIndex );
+    /// \brief Draw the traces of all channels.
+    void drawGraph( Graph &graph );
+    void drawVoltageChannelGraph( ChannelID channel, Graph &graph );
+    void drawHistogramChannelGraph( ChannelID channel, Graph &graph );
+    void drawSpectrumChannelGraph( ChannelID channel, Graph &graph );
+    void drawRollChannelGraph( ChannelID channel, const QMatrix4x4 &graphMatrix );
+    /// \brief x0, dx and repeat of the uniform trace that is drawn next, 0 for complete vertices (Graph::VaoCount).
+    void setGridUniform( const QVector3D &grid );
     QPointF posToScopePos( QPointF pos );
     void rightMouseEvent( QMouseEvent *event );
 
@@ -122,8 +131,19 @@ class GlScope : public QOpenGLWidget {
     QColor triggerLineColor = QColor( "black" );
 
     // Graphs
-    std::list< Graph > m_GraphHistory;
-    unsigned currentGraphInHistory = 0;
+    std::shared_ptr< GraphBuffer > graphBuffer; ///< The traces of the newest frame, see shareGraphsWith()
+    Graph m_Graph;                              ///< The vertex arrays of this scope for graphBuffer
+    PhosphorLayer phosphor;                     ///< The accumulated traces of the digital phosphor
+    unsigned phosphorFrames = 0;                ///< New frames since the last paint, not yet in the phosphor
+    RollGraph rollGraph;  ///< The voltage traces of a rolling frame
+    bool rolling = false; ///< The shown frame is rolling, its voltage traces are in rollGraph
+
+    // Latency tracing, see FrameTrace
+    unsigned shownTag = 0;   ///< Tag of the newest frame written to the graphs
+    FrameStamps shownStamps; ///< ... and its stamps
+    unsigned writeStage;
+    unsigned paintStage;
+    unsigned endToEndStage;
 
     // OpenGL shader, matrix, var-locations
     static QString OpenGLversion;
@@ -136,5 +156,6 @@ class GlScope : public QOpenGLWidget {
     int colorLocation;
     int vertexLocation;
     int matrixLocation;
+    int gridLocation = -1; ///< -1: the shader cannot compute x, uniform traces are uploaded as complete vertices
     int selectionLocation;
 };
@@ -2,25 +2,36 @@
 
 #include "glscopegraph.h"
 #include <QDebug>
+#include <QOpenGLContext>
+#include <algorithm>
 #include <stdexcept>
 
-Graph::Graph() : buffer( QOpenGLBuffer::VertexBuffer ) {
-    buffer.create();
-    buffer.setUsagePattern( QOpenGLBuffer::DynamicDraw );
+
+static int graphBytes( const ChannelGraph &graph, bool shaderX ) {
+    return int( graph.vertices.size() * sizeof( QVector3D ) +
+                graph.values.size() * ( shaderX ? sizeof( float ) : sizeof( QVector3D ) ) );
 }
 
-void Graph::writeData( PPresult *data, QOpenGLShaderProgram *program, int vertexLocation ) {
+
+void GraphBuffer::writeData( const std::shared_ptr< PPresult > &data, bool shaderX ) {
+    if ( data == frame && shaderX == this->shaderX ) // shown by another scope already
+        return;
+    frame = data;
+    this->shaderX = shaderX;
+    ++generation;
+
     // Determine memory
     int neededMemory = 0;
-    for ( ChannelGraph &cg : data->vaChannelVoltage )
-        neededMemory += int( cg.size() * sizeof( QVector3D ) );
-    for ( ChannelGraph &cg : data->vaChannelHistogram )
-        neededMemory += int( cg.size() * sizeof( QVector3D ) );
-    for ( ChannelGraph &cg : data->vaChannelSpectrum )
-        neededMemory += int( cg.size() * sizeof( QVector3D ) );
+    for ( const ChannelsGraphs *graphs :
+          { &data->vaChannelVoltage, &data->vaChannelHistogram, &data->vaChannelSpectrum, &data->vaChannelZoom } )
+        for ( const ChannelGraph &cg : *graphs )
+            neededMemory += graphBytes( cg, shaderX );
 
+    if ( !buffer.isCreated() ) {
+        buffer.create();
+        buffer.setUsagePattern( QOpenGLBuffer::DynamicDraw );
+    }
     buffer.bind();
-    program->bind();
 
     // Allocate space if necessary
     if ( neededMemory > allocatedMem ) {
@@ -30,88 +41,104 @@ void Graph::writeData( PPresult *data, QOpenGLShaderProgram *program, int vertex
 
     // Write data to buffer
     int offset = 0;
-    vaoVoltage.resize( data->vaChannelVoltage.size() );
-    vaoHistogram.resize( data->vaChannelHistogram.size() );
-    vaoSpectrum.resize( data->vaChannelSpectrum.size() );
-    for ( ChannelID channel = 0; channel < std::max( std::max( vaoVoltage.size(), vaoHistogram.size() ), vaoSpectrum.size() );
-          ++channel ) {
-        int dataSize;
-
+    voltage.resize( data->vaChannelVoltage.size() );
+    histogram.resize( data->vaChannelHistogram.size() );
+    spectrum.resize( data->vaChannelSpectrum.size() );
+    zoom.resize( data->vaChannelZoom.size() );
+    const size_t channels = std::max( { voltage.size(), histogram.size(), spectrum.size(), zoom.size() } );
+    for ( ChannelID channel = 0; channel < channels; ++channel ) {
         // Voltage channel
-        if ( channel < vaoVoltage.size() ) {
-            VaoCount &v = vaoVoltage[ channel ];
-            if ( !v.first ) {
-                v.first = new QOpenGLVertexArrayObject;
-                if ( !v.first->create() )
-                    throw new std::runtime_error( "QOpenGLVertexArrayObject create failed" );
-            }
-            ChannelGraph &gVoltage = data->vaChannelVoltage[ channel ];
-            v.first->bind();
-            dataSize = int( gVoltage.size() * sizeof( QVector3D ) );
-            buffer.write( offset, gVoltage.data(), dataSize );
-            program->enableAttributeArray( vertexLocation );
-            program->setAttributeBuffer( vertexLocation, GL_FLOAT, offset, 3, 0 );
-            v.first->release();
-            v.second = int( gVoltage.size() );
-            offset += dataSize;
-        }
+        if ( channel < voltage.size() )
+            writeGraph( voltage[ channel ], data->vaChannelVoltage[ channel ], offset );
 
         // Histogram channel
-        if ( channel < vaoHistogram.size() ) {
-            VaoCount &h = vaoHistogram[ channel ];
-            if ( !h.first ) {
-                h.first = new QOpenGLVertexArrayObject;
-                if ( !h.first->create() )
-                    throw new std::runtime_error( "QOpenGLVertexArrayObject create failed" );
-            }
-            ChannelGraph &gHistogram = data->vaChannelHistogram[ channel ];
-            h.first->bind();
-            dataSize = int( gHistogram.size() * sizeof( QVector3D ) );
-            buffer.write( offset, gHistogram.data(), dataSize );
-            program->enableAttributeArray( vertexLocation );
-            program->setAttributeBuffer( vertexLocation, GL_FLOAT, offset, 3, 0 );
-            h.first->release();
-            h.second = int( gHistogram.size() );
-            offset += dataSize;
-        }
+        if ( channel < histogram.size() )
+            writeGraph( histogram[ channel ], data->vaChannelHistogram[ channel ], offset );
 
         // Spectrum channel
-        if ( channel < vaoSpectrum.size() ) {
-            VaoCount &s = vaoSpectrum[ channel ];
-            if ( !s.first ) {
-                s.first = new QOpenGLVertexArrayObject;
-                if ( !s.first->create() )
-                    throw new std::runtime_error( "QOpenGLVertexArrayObject create failed" );
-            }
-            ChannelGraph &gSpectrum = data->vaChannelSpectrum[ channel ];
-            s.first->bind();
-            dataSize = int( gSpectrum.size() * sizeof( QVector3D ) );
-            buffer.write( offset, gSpectrum.data(), dataSize );
-            program->enableAttributeArray( vertexLocation );
-            program->setAttributeBuffer( vertexLocation, GL_FLOAT, offset, 3, 0 );
-            s.first->release();
-            s.second = int( gSpectrum.size() );
-            offset += dataSize;
-        }
+        if ( channel < spectrum.size() )
+            writeGraph( spectrum[ channel ], data->vaChannelSpectrum[ channel ], offset );
+
+        // Zoomed voltage channel
+        if ( channel < zoom.size() )
+            writeGraph( zoom[ channel ], data->vaChannelZoom[ channel ], offset );
     }
 
     buffer.release();
+    // the other contexts see the new content only after this one has flushed it
+    QOpenGLContext::currentContext()->functions()->glFlush();
 }
 
-Graph::~Graph() {
-    for ( auto &vao : vaoVoltage ) {
-        vao.first->destroy();
-        delete vao.first;
-    }
-    for ( auto &vao : vaoHistogram ) {
-        vao.first->destroy();
-        delete vao.first;
-    }
-    for ( auto &vao : vaoSpectrum ) {
-        vao.first->destroy();
-        delete vao.first;
-    }
+
+void GraphBuffer::writeGraph( Range &range, const ChannelGraph &graph, int &offset ) {
+    range.offset = offset;
+    range.count = GLsizei( graph.size() );
+    range.tupleSize = 3;
+    range.grid = QVector3D();
+    if ( !graph.values.empty() && shaderX ) { // only y, the shader adds x
+        buffer.write( offset, graph.values.data(), graphBytes( graph, shaderX ) );
+        range.tupleSize = 1;
+        range.grid = QVector3D( graph.x0, graph.dx, float( graph.repeat ) );
+    } else if ( !graph.values.empty() ) {
+        expanded.resize( graph.values.size() );
+        for ( size_t index = 0; index < graph.values.size(); ++index )
+            expanded[ index ] = QVector3D( graph.x( index ), graph.values[ index ], 0.0f );
+        buffer.write( offset, expanded.data(), graphBytes( graph, shaderX ) );
+    } else
+        buffer.write( offset, graph.vertices.data(), graphBytes( graph, shaderX ) );
+    offset += graphBytes( graph, shaderX );
+}
+
+
+GraphBuffer::~GraphBuffer() {
     if ( buffer.isCreated() ) {
         buffer.destroy();
     }
 }
+
+
+void Graph::bind( GraphBuffer &source, QOpenGLShaderProgram *program, int vertexLocation ) {
+    if ( source.generation == generation )
+        return;
+    generation = source.generation;
+    program->bind();
+    // the buffer is bound while the vertex arrays record the attributes
+    source.buffer.bind();
+    bindGraphs( vaoVoltage, source.voltage, program, vertexLocation );
+    bindGraphs( vaoHistogram, source.histogram, program, vertexLocation );
+    bindGraphs( vaoSpectrum, source.spectrum, program, vertexLocation );
+    bindGraphs( vaoZoom, source.zoom, program, vertexLocation );
+    source.buffer.release();
+}
+
+
+void Graph::bindGraphs( std::vector< VaoCount > &vaos, const std::vector< GraphBuffer::Range > &ranges,
+                        QOpenGLShaderProgram *program, int vertexLocation ) {
+    vaos.resize( ranges.size() );
+    for ( size_t index = 0; index < ranges.size(); ++index ) {
+        VaoCount &v = vaos[ index ];
+        if ( !v.vao ) {
+            v.vao = new QOpenGLVertexArrayObject;
+            if ( !v.vao->create() )
+                throw new std::runtime_error( "QOpenGLVertexArrayObject create failed" );
+        }
+        v.vao->bind();
+        program->enableAttributeArray( vertexLocation );
+        program->setAttributeBuffer( vertexLocation, GL_FLOAT, ranges[ index ].offset, ranges[ index ].tupleSize, 0 );
+        v.vao->release();
+        v.count = ranges[ index ].count;
+        v.grid = ranges[ index ].grid;
+    }
+}
+
+
+void Graph::destroy() {
+    for ( std::vector< VaoCount > *vaos : { &vaoVoltage, &vaoHistogram, &vaoSpectrum, &vaoZoom } ) {
+        for ( auto &vao : *vaos ) {
+            vao.vao->destroy();
+            delete vao.vao;
+        }
+        vaos->clear();
+    }
+    generation = 0;
+}
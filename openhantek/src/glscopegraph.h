@@ -13,18 +13,70 @@
 
 #include "post/ppresult.h"
 
+/// \brief The vertices of all traces of one frame in one GPU buffer, shared by the scopes that show this frame.
+/// The contexts of all scopes share their objects (Qt::AA_ShareOpenGLContexts), the first scope that shows a frame
+/// uploads it, the others only point their vertex arrays to it (Graph::bind()).
+struct GraphBuffer {
+    GraphBuffer() = default;
+    GraphBuffer( const GraphBuffer & ) = delete;
+    ~GraphBuffer();
+    /// \brief Upload all traces of `data` unless they are in the buffer already.
+    /// \param shaderX The vertex shader computes the x of uniform traces (ChannelGraph::values), only their y
+    /// values are uploaded (4 instead of 12 bytes per vertex). Else they are expanded to (x, y, 0) vertices.
+    void writeData( const std::shared_ptr< PPresult > &data, bool shaderX );
+    /// \brief The place of one trace in the buffer.
+    struct Range {
+        int offset = 0;
+        GLsizei count = 0;
+        int tupleSize = 3; ///< 1: only y of a uniform trace
+        QVector3D grid;    ///< x0, dx and repeat of a uniform trace, the value of the `grid` uniform; repeat 0: free vertices
+    };
+
+  public:
+    QOpenGLBuffer buffer = QOpenGLBuffer( QOpenGLBuffer::VertexBuffer );
+    std::vector< Range > voltage;
+    std::vector< Range > histogram;
+    std::vector< Range > spectrum;
+    std::vector< Range > zoom; ///< Voltage traces between the markers, for the zoom scope
+    unsigned generation = 0; ///< Counts the uploads, the ranges of a new one may have moved
+
+  private:
+    /// \brief Write `graph` at `offset` of the buffer and describe it in `range`, `offset` is advanced.
+    void writeGraph( Range &range, const ChannelGraph &graph, int &offset );
+    /// The uploaded frame, this reference keeps the pool from recycling it, so an equal pointer is the same frame
+    std::shared_ptr< const PPresult > frame;
+    bool shaderX = false;
+    int allocatedMem = 0;
+    std::vector< QVector3D > expanded; ///< Uniform traces as free vertices if the shader cannot compute x
+};
+
+
+/// \brief The vertex arrays of one scope for the traces in a GraphBuffer.
+/// Vertex arrays are not shared between contexts, every scope keeps its own.
 struct Graph {
-    explicit Graph();
+    Graph() = default;
     Graph( const Graph & ) = delete;
-    Graph( const Graph && ) = delete;
-    ~Graph();
-    void writeData( PPresult *data, QOpenGLShaderProgram *program, int vertexLocation );
-    typedef std::pair< QOpenGLVertexArrayObject *, GLsizei > VaoCount;
+    ~Graph() { destroy(); }
+    /// \brief Release the vertex arrays, the context must be current. The next bind() creates them again.
+    void destroy();
+    /// \brief Point the vertex arrays to the traces of `source`, if it has uploaded a new frame since the last call.
+    void bind( GraphBuffer &source, QOpenGLShaderProgram *program, int vertexLocation );
+    /// \brief A frame has been bound, the vertex arrays exist.
+    bool isBound() const { return generation != 0; }
+    struct VaoCount {
+        QOpenGLVertexArrayObject *vao = nullptr;
+        GLsizei count = 0;
+        QVector3D grid; ///< See GraphBuffer::Range
+    };
 
   public:
-    int allocatedMem = 0;
-    QOpenGLBuffer buffer;
     std::vector< VaoCount > vaoVoltage;
     std::vector< VaoCount > vaoHistogram;
     std::vector< VaoCount > vaoSpectrum;
+    std::vector< VaoCount > vaoZoom;
+
+  private:
+    void bindGraphs( std::vector< VaoCount > &vaos, const std::vector< GraphBuffer::Range > &ranges,
+                     QOpenGLShaderProgram *program, int vertexLocation );
+    unsigned generation = 0; ///< Of the bound upload
 };
@@ -0,0 +1,186 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <QOpenGLContext>
+#include <QVector2D>
+
+#include "glscope.h"
+#include "glscopephosphor.h"
+
+#ifndef GL_RGBA16
+#define GL_RGBA16 0x805B
+#endif
+
+
+void PhosphorLayer::destroy() {
+    framebuffer.reset();
+    program.reset();
+    if ( vao.isCreated() )
+        vao.destroy();
+    if ( quad.isCreated() )
+        quad.destroy();
+}
+
+
+bool PhosphorLayer::create( const QString &glslVersion, QString &log ) {
+    // a full screen quad in clip coordinates, it shows the texture 1:1
+    const char *vertexShaderGL100ES = R"(
+          #version 100
+          attribute highp vec2 vertex;
+          varying highp vec2 texCoord;
+          void main()
+          {
+              texCoord = vertex * 0.5 + 0.5;
+              gl_Position = vec4(vertex, 0.0, 1.0);
+          }
+    )";
+
+    const char *vertexShaderGLSL120 = R"(
+          #version 120
+          attribute highp vec2 vertex;
+          varying highp vec2 texCoord;
+          void main()
+          {
+              texCoord = vertex * 0.5 + 0.5;
+              gl_Position = vec4(vertex, 0.0, 1.0);
+          }
+    )";
+
+    const char *vertexShaderGLSL150 = R"(
+          #version 150
+          in highp vec2 vertex;
+          out highp vec2 texCoord;
+          void main()
+          {
+              texCoord = vertex * 0.5 + 0.5;
+              gl_Position = vec4(vertex, 0.0, 1.0);
+          }
+    )";
+
+    const char *fragmentShaderGL100ES = R"(
+          #version 100
+          uniform sampler2D phosphor;
+          uniform mediump float fadeStep;
+          varying highp vec2 texCoord;
+          void main() { gl_FragColor = fadeStep > 0.0 ? vec4(fadeStep) : texture2D(phosphor, texCoord); }
+    )";
+
+    const char *fragmentShaderGLSL120 = R"(
+          #version 120
+          uniform sampler2D phosphor;
+          uniform float fadeStep;
+          varying highp vec2 texCoord;
+          void main() { gl_FragColor = fadeStep > 0.0 ? vec4(fadeStep) : texture2D(phosphor, texCoord); }
+    )";
+
+    const char *fragmentShaderGLSL150 = R"(
+          #version 150
+          uniform sampler2D phosphor;
+          uniform float fadeStep;
+          in highp vec2 texCoord;
+          out vec4 flatColor;
+          void main() { flatColor = fadeStep > 0.0 ? vec4(fadeStep) : texture(phosphor, texCoord); }
+    )";
+
+    auto p = std::unique_ptr< QOpenGLShaderProgram >( new QOpenGLShaderProgram );
+    const char *vertexShader = vertexShaderGLSL120;
+    const char *fragmentShader = fragmentShaderGLSL120;
+    if ( GLSL150 == glslVersion ) {
+        vertexShader = vertexShaderGLSL150;
+        fragmentShader = fragmentShaderGLSL150;
+    } else if ( GLES100 == glslVersion ) {
+        vertexShader = vertexShaderGL100ES;
+        fragmentShader = fragmentShaderGL100ES;
+    }
+    if ( !p->addShaderFromSourceCode( QOpenGLShader::Vertex, vertexShader ) ||
+         !p->addShaderFromSourceCode( QOpenGLShader::Fragment, fragmentShader ) || !p->link() || !p->bind() ) {
+        log = p->log();
+        return false;
+    }
+    p->setUniformValue( "phosphor", 0 ); // texture unit 0
+    fadeStepLocation = p->uniformLocation( "fadeStep" );
+    p->setUniformValue( fadeStepLocation, 0.0f );
+
+    // counter-clockwise, the scope culls back faces
+    const QVector2D corners[] = { { -1.0f, -1.0f }, { 1.0f, -1.0f }, { -1.0f, 1.0f }, { 1.0f, 1.0f } };
+    if ( !vao.create() ) {
+        log = "QOpenGLVertexArrayObject create failed";
+        return false;
+    }
+    QOpenGLVertexArrayObject::Binder b( &vao );
+    quad.create();
+    quad.bind();
+    quad.setUsagePattern( QOpenGLBuffer::StaticDraw );
+    quad.allocate( corners, int( sizeof( corners ) ) );
+    const int vertexLocation = p->attributeLocation( "vertex" );
+    p->enableAttributeArray( vertexLocation );
+    p->setAttributeBuffer( vertexLocation, GL_FLOAT, 0, 2, 0 );
+    quad.release();
+    p->release();
+    program = std::move( p );
+    return true;
+}
+
+
+void PhosphorLayer::beginFrame( QOpenGLFunctions *gl, float decay ) {
+    gl->glGetIntegerv( GL_VIEWPORT, viewport );
+    const QSize pixels( viewport[ 2 ], viewport[ 3 ] );
+    const bool fresh = !framebuffer || framebuffer->size() != pixels;
+    if ( fresh ) { // no depth buffer, the traces of one frame do not hide each other
+        // 16 bits per channel where the desktop GL can render to it, 8 bits (GLES) fade to 10 % only for short depths
+        framebuffer.reset();
+        if ( !QOpenGLContext::currentContext()->isOpenGLES() ) {
+            framebuffer.reset(
+                new QOpenGLFramebufferObject( pixels, QOpenGLFramebufferObject::NoAttachment, GL_TEXTURE_2D, GL_RGBA16 ) );
+            fadeStep = 1.0f / 65535.0f;
+        }
+        if ( !framebuffer || !framebuffer->isValid() ) {
+            framebuffer.reset( new QOpenGLFramebufferObject( pixels, QOpenGLFramebufferObject::NoAttachment ) );
+            fadeStep = 1.0f / 255.0f;
+        }
+    }
+    framebuffer->bind();
+    gl->glViewport( 0, 0, pixels.width(), pixels.height() );
+    if ( fresh ) {
+        gl->glClearColor( 0.0f, 0.0f, 0.0f, 0.0f );
+        gl->glClear( GL_COLOR_BUFFER_BIT );
+    } else if ( decay < 1.0f ) {
+        // destination = destination * decay - fadeStep, the texture is not sampled while it is the target
+        // A multiply alone stops at the values whose loss is below half a quantum of the texture (0.5 / (1 - decay)
+        // quanta), the subtracted quantum lets every trace reach 0.
+        program->bind();
+        program->setUniformValue( fadeStepLocation, fadeStep );
+        gl->glBindTexture( GL_TEXTURE_2D, 0 );
+        gl->glBlendColor( decay, decay, decay, decay );
+        gl->glBlendEquation( GL_FUNC_REVERSE_SUBTRACT );
+        gl->glBlendFunc( GL_ONE, GL_CONSTANT_COLOR );
+        QOpenGLVertexArrayObject::Binder b( &vao );
+        gl->glDrawArrays( GL_TRIANGLE_STRIP, 0, 4 );
+        gl->glBlendEquation( GL_FUNC_ADD );
+        program->setUniformValue( fadeStepLocation, 0.0f );
+        program->release();
+    }
+    // the traces are blended as on the screen, the alpha accumulates for the composition
+    gl->glBlendFuncSeparate( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA );
+}
+
+
+void PhosphorLayer::endFrame( QOpenGLFunctions *gl, GLuint target ) {
+    gl->glBindFramebuffer( GL_FRAMEBUFFER, target );
+    gl->glViewport( viewport[ 0 ], viewport[ 1 ], viewport[ 2 ], viewport[ 3 ] );
+    gl->glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+}
+
+
+void PhosphorLayer::composite( QOpenGLFunctions *gl ) {
+    if ( !framebuffer )
+        return;
+    program->bind();
+    gl->glActiveTexture( GL_TEXTURE0 );
+    gl->glBindTexture( GL_TEXTURE_2D, framebuffer->texture() );
+    gl->glBlendFunc( GL_ONE, GL_ONE_MINUS_SRC_ALPHA ); // premultiplied
+    QOpenGLVertexArrayObject::Binder b( &vao );
+    gl->glDrawArrays( GL_TRIANGLE_STRIP, 0, 4 );
+    gl->glBindTexture( GL_TEXTURE_2D, 0 );
+    gl->glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+    program->release();
+}
@@ -0,0 +1,49 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <memory>
+
+#include <QOpenGLBuffer>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLVertexArrayObject>
+#include <QString>
+
+/// \brief The digital phosphor of a scope, the traces of all frames accumulated in one texture.
+/// Every new frame first fades the texture by a decay factor (a blended full screen quad) and then draws its
+/// traces on top, the texture is composited over the screen at every paint. The cost per frame does not depend
+/// on the persistence and a trace that is hit often stays brighter than a rare one (intensity grading).
+/// The texture holds premultiplied colors over transparency, the markers and the grid stay on the screen.
+/// It has 16 bits per channel if the context can render to them, every fade also subtracts one quantum, so even
+/// the slow decay of a deep persistence takes the traces down to 0 instead of leaving them at a rounding floor.
+struct PhosphorLayer {
+    PhosphorLayer() = default;
+    PhosphorLayer( const PhosphorLayer & ) = delete;
+    ~PhosphorLayer() { destroy(); }
+    /// \brief Compile the shader of `glslVersion` (GLSL150, GLSL120 or GLES100), the context must be current.
+    /// \return false and the compiler log in `log` if the phosphor is not available.
+    bool create( const QString &glslVersion, QString &log );
+    bool isCreated() const { return bool( program ); }
+    /// \brief Release the GL objects, the context must be current.
+    void destroy();
+    /// \brief Forget the accumulated traces.
+    void clear() { framebuffer.reset(); }
+    /// \brief Fade the texture by `decay` and bind it as render target, the following draws accumulate.
+    /// The texture has the size of the current viewport, a new size starts an empty texture.
+    void beginFrame( QOpenGLFunctions *gl, float decay );
+    /// \brief Bind `target` (the framebuffer of the widget) again, after the traces were drawn.
+    void endFrame( QOpenGLFunctions *gl, GLuint target );
+    /// \brief Blend the accumulated traces over the current render target.
+    void composite( QOpenGLFunctions *gl );
+
+  private:
+    std::unique_ptr< QOpenGLShaderProgram > program;
+    std::unique_ptr< QOpenGLFramebufferObject > framebuffer;
+    QOpenGLBuffer quad = QOpenGLBuffer( QOpenGLBuffer::VertexBuffer );
+    QOpenGLVertexArrayObject vao;
+    int viewport[ 4 ] = { 0, 0, 0, 0 }; ///< Of the screen, restored by endFrame()
+    int fadeStepLocation = -1;          ///< Uniform of the shader, > 0: it draws this constant instead of the texture
+    float fadeStep = 1.0f / 255.0f;     ///< One quantum of the texture format
+};
@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "glscoperollgraph.h"
+#include "scopesettings.h"
+#include "viewconstants.h"
+
+
+void RollGraph::destroy() {
+    for ( Ring &ring : rings ) {
+        if ( ring.vao ) {
+            ring.vao->destroy();
+            delete ring.vao;
+        }
+        if ( ring.buffer.isCreated() )
+            ring.buffer.destroy();
+    }
+    rings.clear();
+}
+
+
+void RollGraph::writeData( const PPresult *data, const DsoSettingsScope *scope, QOpenGLShaderProgram *program,
+                           int vertexLocation ) {
+    uploadedVertices = 0;
+    rings.resize( scope->voltage.size() );
+    for ( ChannelID channel = 0; channel < rings.size(); ++channel ) {
+        Ring &ring = rings[ channel ];
+        const DataChannel *channelData = data->data( channel );
+        if ( !scope->voltage[ channel ].used || !channelData || channelData->voltage.samples->size() < 2 ) {
+            ring.newest = ring.first - 1;
+            continue;
+        }
+        const std::vector< Sample > &samples = *channelData->voltage.samples;
+        // the visible part as GraphGenerator::generateGraphTYvoltage() shows an untriggered trace
+        const double horizontalFactor = channelData->voltage.interval / scope->horizontal.timebase;
+        const int64_t dotsOnScreen = int64_t( std::ceil( DIVS_TIME / horizontalFactor ) );
+        const int64_t size = int64_t( samples.size() );
+        const int64_t origin = channelData->gridOrigin;
+        const int64_t first = origin + std::max( size - dotsOnScreen, int64_t( 0 ) ) + 1;
+        const int64_t newest = origin + size - 1;
+        const double gain = scope->gain( channel );
+        const double offset = scope->voltage[ channel ].offset;
+
+        // the newest vertex is written again, a late sample with the same time stamp may have changed it
+        const bool restart = gain != ring.gain || offset != ring.offset || horizontalFactor != ring.horizontalFactor ||
+                             newest - first + 1 > ring.capacity || newest < ring.newest || first > ring.newest ||
+                             newest - ring.base > std::max( int64_t( 1 ) << 20, 4 * ring.capacity ); // float precision
+        if ( restart ) {
+            const int64_t needed = dotsOnScreen + 1;
+            if ( needed > ring.capacity ) {
+                ring.capacity = 2 * needed; // room for zooming out a bit without a new allocation
+                if ( !ring.buffer.isCreated() ) {
+                    ring.buffer.create();
+                    ring.buffer.setUsagePattern( QOpenGLBuffer::DynamicDraw );
+                }
+                ring.buffer.bind();
+                ring.buffer.allocate( int( ( ring.capacity + 1 ) * int64_t( sizeof( QVector2D ) ) ) );
+                ring.buffer.release();
+            }
+            if ( !ring.vao ) {
+                ring.vao = new QOpenGLVertexArrayObject;
+                if ( !ring.vao->create() )
+                    throw new std::runtime_error( "QOpenGLVertexArrayObject create failed" );
+                ring.vao->bind();
+                ring.buffer.bind();
+                program->enableAttributeArray( vertexLocation );
+                program->setAttributeBuffer( vertexLocation, GL_FLOAT, 0, 2, 0 ); // z = 0
+                ring.vao->release();
+                ring.buffer.release();
+            }
+            ring.base = first;
+            ring.newest = first;
+            ring.gain = gain;
+            ring.offset = offset;
+            ring.horizontalFactor = horizontalFactor;
+        }
+        upload( ring, samples, origin, restart ? first : ring.newest, newest );
+        ring.first = first;
+        ring.newest = newest;
+    }
+}
+
+
+void RollGraph::upload( Ring &ring, const std::vector< Sample > &samples, int64_t origin, int64_t from, int64_t to ) {
+    if ( to < from )
+        return;
+    vertices.resize( size_t( to - from + 1 ) );
+    for ( int64_t index = from; index <= to; ++index )
+        vertices[ size_t( index - from ) ] =
+            QVector2D( float( index - ring.base ), float( samples[ size_t( index - origin ) ] / ring.gain + ring.offset ) );
+    uploadedVertices += vertices.size();
+
+    ring.buffer.bind();
+    // up to the end of the ring and the rest from its begin, the vertex of slot 0 is copied behind the end
+    // so that a strip that wraps around stays connected
+    const int vertexBytes = int( sizeof( QVector2D ) );
+    const int64_t slot = slotOf( ring, from );
+    const int64_t head = std::min( ring.capacity - slot, int64_t( vertices.size() ) );
+    ring.buffer.write( int( slot ) * vertexBytes, vertices.data(), int( head ) * vertexBytes );
+    if ( head < int64_t( vertices.size() ) ) {
+        ring.buffer.write( 0, vertices.data() + head, int( int64_t( vertices.size() ) - head ) * vertexBytes );
+        ring.buffer.write( int( ring.capacity ) * vertexBytes, vertices.data() + head, vertexBytes );
+    } else if ( 0 == slot )
+        ring.buffer.write( int( ring.capacity ) * vertexBytes, vertices.data(), vertexBytes );
+    ring.buffer.release();
+}
+
+
+void RollGraph::clear() {
+    for ( Ring &ring : rings ) {
+        ring.newest = ring.first - 1;
+        ring.gain = 0.0; // restart with a full upload
+    }
+}
+
+
+void RollGraph::draw( ChannelID channel, QOpenGLFunctions *gl, GLenum mode ) {
+    if ( channel >= rings.size() || !rings[ channel ].vao || rings[ channel ].newest < rings[ channel ].first )
+        return;
+    const Ring &ring = rings[ channel ];
+    const GLint begin = GLint( slotOf( ring, ring.first ) );
+    const GLint end = GLint( slotOf( ring, ring.newest ) );
+    QOpenGLVertexArrayObject::Binder b( ring.vao );
+    if ( begin <= end )
+        gl->glDrawArrays( mode, begin, end - begin + 1 );
+    else { // wrapped, the first part ends with the copy of slot 0
+        gl->glDrawArrays( mode, begin, GLsizei( ring.capacity ) - begin + 1 );
+        gl->glDrawArrays( mode, 0, end + 1 );
+    }
+}
+
+
+QMatrix4x4 RollGraph::transform( ChannelID channel ) const {
+    QMatrix4x4 m;
+    if ( channel >= rings.size() )
+        return m;
+    const Ring &ring = rings[ channel ];
+    // the leftmost visible vertex at the left margin, one grid interval is horizontalFactor divs wide
+    m.translate( float( MARGIN_LEFT - double( ring.first - ring.base ) * ring.horizontalFactor ), 0.0f, 0.0f );
+    m.scale( float( ring.horizontalFactor ), 1.0f, 1.0f );
+    return m;
+}
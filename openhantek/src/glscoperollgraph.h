@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <vector>
+
+#include <QMatrix4x4>
+#include <QOpenGLBuffer>
+#include <QOpenGLFunctions>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLVertexArrayObject>
+#include <QVector2D>
+
+#include "post/ppresult.h"
+
+struct DsoSettingsScope;
+
+/// \brief The voltage traces of the roll mode, one GPU ring buffer of vertices per channel.
+/// A rolling trace only moves to the left, so every frame uploads just the samples that are new since the last
+/// one (`glBufferSubData` of one or two ranges). A vertex holds the grid index of its sample, relative to a base,
+/// and its screen y. The scrolling is a translation of x in the matrix of the shader (transform()).
+/// Changed gain, offset or timebase, a gap or a jump back in the grid start the ring over with a full upload.
+struct RollGraph {
+    RollGraph() = default;
+    RollGraph( const RollGraph & ) = delete;
+    ~RollGraph() { destroy(); }
+    /// \brief Append the new samples of the rolling frame `data` (PPresult::rolling) to the rings.
+    void writeData( const PPresult *data, const DsoSettingsScope *scope, QOpenGLShaderProgram *program, int vertexLocation );
+    /// \brief Forget the traces, the next rolling frame uploads the visible samples again.
+    void clear();
+    /// \brief Release the rings, the context must be current.
+    void destroy();
+    /// \brief Draw the trace of `channel` with the current program, its matrix must include transform().
+    void draw( ChannelID channel, QOpenGLFunctions *gl, GLenum mode );
+    /// \brief Maps the vertices of `channel` to the scope coordinates (divs).
+    QMatrix4x4 transform( ChannelID channel ) const;
+    /// \brief Vertices uploaded by the last writeData(), for all channels.
+    size_t uploaded() const { return uploadedVertices; }
+
+  private:
+    struct Ring {
+        QOpenGLBuffer buffer = QOpenGLBuffer( QOpenGLBuffer::VertexBuffer );
+        QOpenGLVertexArrayObject *vao = nullptr;
+        int64_t capacity = 0;  ///< Vertices in the ring, the buffer has one more for the copy of vertex 0
+        int64_t base = 0;      ///< Grid index of x = 0
+        int64_t first = 0;     ///< Grid index of the leftmost visible vertex
+        int64_t newest = -1;   ///< Grid index of the newest vertex, < first: empty
+        double gain = 0.0;     ///< Settings the y values were computed with
+        double offset = 0.0;
+        double horizontalFactor = 0.0; ///< Divs per grid interval
+    };
+    /// \brief Position of the vertex of grid index `index` in the ring, the index may be negative.
+    static int64_t slotOf( const Ring &ring, int64_t index ) { return ( index % ring.capacity + ring.capacity ) % ring.capacity; }
+    /// \brief Write the vertices of the grid indices [from, to] of `samples` (index 0 at `origin`) into the ring.
+    void upload( Ring &ring, const std::vector< Sample > &samples, int64_t origin, int64_t from, int64_t to );
+
+    std::vector< Ring > rings;
+    std::vector< QVector2D > vertices; ///< Staging of the new vertices, reused
+    size_t uploadedVertices = 0;
+};
@@ -2,15 +2,21 @@
 
 #pragma once
 
+#include "input/samplestore.h"
+#include "utils/frametrace.h"
 #include "utils/printutils.h"
 #include <QReadLocker>
 #include <QReadWriteLock>
 #include <QWriteLocker>
+#include <cstdint>
 #include <vector>
 
 struct DSOsamples {
-    std::vector< std::vector< double >* > data; ///< Pointer to input data from device
-    double samplerate = 0.0;                   ///< The samplerate of the input data
+    std::vector< SampleSnapshot > data;         ///< Stable views of the newest input data per channel
+    std::vector< int64_t > startTime;           ///< Time (ns) of the first point of the uniform grid per channel
+    size_t sampleCount = 0;                    ///< Points of the uniform grid the snapshots are resampled to
+    double samplerate = 0.0;                   ///< The samplerate of the uniform grid
+    size_t envelopeStride = 1;                 ///< Grid points per column of the min/max envelope, 1: none
     unsigned char clipped = 0;                 ///< Bitmask of clipped channels
     bool liveTrigger = false;                  ///< live samples are triggered
     int triggeredPosition = 0;                 ///< position for a triggered trace, 0 = not triggered
@@ -19,6 +25,7 @@ struct DSOsamples {
     Unit mathVoltageUnit = UNIT_VOLTS;         ///< unless UNIT_VOLTSQUARE for some math functions
     bool freeRunning = false;                  ///< trigger: NONE, half sample count
     unsigned tag = 0;                          ///< track individual sample blocks (debug support)
+    FrameStamps stamps;                        ///< read, parsed and built times of the newest input of this frame
     mutable QReadWriteLock lock;
 };
 
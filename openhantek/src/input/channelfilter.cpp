@@ -0,0 +1,40 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "channelfilter.h"
+
+
+ChannelFilter::ChannelFilter( std::vector< std::string > patterns ) : patterns( std::move( patterns ) ) {}
+
+
+bool ChannelFilter::matches( const std::string &qualifiedName ) const {
+    for ( const std::string &pattern : patterns )
+        if ( wildcardMatch( pattern.data(), pattern.size(), qualifiedName.data(), qualifiedName.size() ) )
+            return true;
+    return false;
+}
+
+
+// static
+bool ChannelFilter::wildcardMatch( const char *pattern, size_t patternSize, const char *name, size_t nameSize ) {
+    // greedy match with backtracking to the last '*', linear for the usual patterns
+    size_t p = 0;
+    size_t n = 0;
+    size_t star = patternSize; // position of the last '*' in the pattern, none yet
+    size_t starName = 0;       // name position matched by that '*'
+    while ( n < nameSize ) {
+        if ( p < patternSize && ( pattern[ p ] == '?' || pattern[ p ] == name[ n ] ) ) {
+            ++p;
+            ++n;
+        } else if ( p < patternSize && pattern[ p ] == '*' ) {
+            star = p++;
+            starName = n;
+        } else if ( star < patternSize ) { // let the last '*' swallow one more character
+            p = star + 1;
+            n = ++starName;
+        } else
+            return false;
+    }
+    while ( p < patternSize && pattern[ p ] == '*' )
+        ++p;
+    return p == patternSize;
+}
@@ -0,0 +1,28 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+
+/// \brief Decides which channels are subscribed, i.e. parsed and stored.
+///
+/// A channel is subscribed if its qualified name "prefix:name" matches one of the patterns.
+/// Patterns are matched as a whole, '*' matches any sequence and '?' any single character,
+/// e.g. "server:*Frame*" or "*:GameThread". No pattern, no subscribed channel.
+/// A filter is immutable after construction, copies can be used by several threads.
+class ChannelFilter {
+  public:
+    ChannelFilter() = default;
+    explicit ChannelFilter( std::vector< std::string > patterns );
+
+    bool matches( const std::string &qualifiedName ) const;
+    bool empty() const { return patterns.empty(); }
+
+    /// \brief Match `name` against one pattern with '*' and '?' wildcards.
+    static bool wildcardMatch( const char *pattern, size_t patternSize, const char *name, size_t nameSize );
+
+  private:
+    std::vector< std::string > patterns;
+};
@@ -1,149 +1,111 @@
 #include "dsoinput.h"
+#include "logsource.h"
+#include "streamsource.h"
+#include "viewconstants.h"
 #include <QtCore>
+#include <algorithm>
+#include <cmath>
 
+// followed if neither the command line nor the settings name a log file or a stream
 static QString filePath = "E:\\nzm_mobile_code2\\NZMobile\\Saved\\Logs\\NZM.log";
 //static QString filePath = "E:\\nzm_release2\\NZMobile\\Saved\\Logs\\NZM.log";
 //static QString filePath = "D:\\Users\\hayli\\Documents\\Unreal Projects\\alsv\\Saved\\Logs\\ALSV4_0.log";
-static QString KeyTemplate = "ScopeData: ";
 
-static bool isScopeData(QString& s)
+DsoInput::DsoInput(DsoSettings *settings, int verboseLevel ):controlsettings(nullptr, 4),dsoSettings(settings),verboseLevel(verboseLevel),
+    mailbox(settings ? settings->scope.input.frameSlots : 1),
+    buildStage(FrameTrace::instance().stage("build frame"))
 {
-    int index = s.indexOf(KeyTemplate);
-    if(index != -1)
-    {
-        s = s.trimmed();
-        s = s.mid(index + KeyTemplate.size());
-        return true;
-    }
-    return false;
+    if(dsoSettings)
+        recordTime = dsoSettings->scope.horizontal.timebase * DIVS_TIME;
+    // a parent and not a plain member, the timer has to move with this object into its thread
+    discoveryTimer = new QTimer(this);
+    discoveryTimer->setSingleShot(true);
+    discoveryTimer->setInterval(250);
+    connect(discoveryTimer, &QTimer::timeout, this, &DsoInput::publishChannels);
 }
 
-static bool isSep(const QChar& ch)
+DsoInput::~DsoInput()
 {
-    static QSet<QChar> seps = {
-        ':',
-        ',',
-    };
-    return seps.contains(ch);
-}
 
-static bool isDot(const QChar& ch)
-{
-    return ch == '.';
 }
 
-QVector<QString> LexicalParser(const QString& s)
+void DsoInput::quitSampling()
 {
-    QVector<QString> tokens;
-    int startPos = 0;
-    int maxLen = s.size();
-    while(startPos < maxLen)
-    {
-        const QChar ch = s[startPos];
-        if(ch.isSpace())
-        {
-        }
-        else if(ch.isLetter())
-        {
-            int scanPos = startPos + 1;
-            while(scanPos < maxLen && s[scanPos].isLetterOrNumber())
-                ++scanPos;
-            tokens.push_back(s.mid(startPos, scanPos-startPos));
-            startPos = scanPos - 1;
-        }
-        else if(ch.isDigit() || isDot(ch) || ch == '-')
-        {
-            bool hasDot = isDot(ch);
-            int scanPos = startPos + 1;
-            while(scanPos < maxLen)
-            {
-                if(isDot(s[scanPos]))
-                {
-                    if(hasDot)
-                    {
-                        break;
-                    }
-                    hasDot = true;
-                }
-                else if(!s[scanPos].isDigit())
-                {
-                    break;
-                }
-                ++scanPos;
-            }
-            tokens.push_back(s.mid(startPos, scanPos-startPos));
-            startPos = scanPos - 1;
-        }
-        else if(isSep(ch))
-        {
-            tokens.push_back(ch);
-        }
-        ++startPos;
-    }
-    return tokens;
+    bQuit = true;
+    capturing = false;
 }
 
-struct AnalysedChannelData
+void DsoInput::StartSample()
 {
-    float sampleTime;
-    QVector<QPair<QString, float>> datas;
-};
+    emit start();
+}
 
-AnalysedChannelData DataParser(const QVector<QString>& tokens)
+void DsoInput::addSources()
 {
-    AnalysedChannelData data;
-    bool bOk = false;
-    if (tokens.size() > 2)
+    const QStringList& streams = dsoSettings->scope.input.streams;
+    QStringList logFiles = dsoSettings->scope.input.logFiles;
+    if(logFiles.isEmpty() && streams.isEmpty())
+        logFiles << filePath;
+    for(const QString& logFile : logFiles)
     {
-        data.sampleTime = tokens[2].toFloat(&bOk);
-        if(!bOk)
-            return data;
+        // "prefix=file" or just "file", then the base name of the file is the prefix
+        const int separator = logFile.indexOf('=');
+        const QString fileName = separator > 0 ? logFile.mid(separator + 1) : logFile;
+        const QString prefix = separator > 0 ? logFile.left(separator) : QFileInfo(fileName).completeBaseName();
+        LogSource* source = new LogSource(fileName, prefix, dsoSettings->scope.input.logCache, verboseLevel);
+        source->setBackfillOnSubscribe(dsoSettings->scope.input.backfillOnSubscribe);
+        sources->addSource(source);
     }
-
-    for(int i=4;i+2<tokens.size();i+=4)
+    for(const QString& stream : streams)
     {
-        float v = tokens[i+2].toFloat(&bOk);
-        if(!bOk)
-            return data;
-        data.datas.push_back(qMakePair(tokens[i], v));
+        // "prefix=address" or just "address", the producers name their channels themselves
+        const int separator = stream.indexOf('=');
+        const QString address = separator > 0 ? stream.mid(separator + 1) : stream;
+        const QString prefix = separator > 0 ? stream.left(separator) : QString("stream");
+        sources->addSource(new StreamSource(address, prefix, verboseLevel));
     }
-    return data;
 }
 
-DsoInput::DsoInput(DsoSettings *settings, int verboseLevel ):controlsettings(nullptr, 4),dsoSettings(settings)
+void DsoInput::channelsChanged()
 {
-
+    // a log with thousands of channels discovers them one by one, the docks are refilled only once per batch
+    if(!discoveryTimer->isActive())
+        discoveryTimer->start();
 }
 
-DsoInput::~DsoInput()
-{
-
-}
-
-void DsoInput::quitSampling()
+void DsoInput::publishChannels()
 {
-    bQuit = true;
-    capturing = false;
+    if(!sources)
+        return;
+    updateRetention(); // a new channel may be subscribed and take its share of the memory budget
+    dsoSettings->scope.AvaliableChannelNames = sources->channelNames();
+    emit newChannelData(&dsoSettings->scope);
 }
 
-void DsoInput::StartSample()
+void DsoInput::updateSubscription()
 {
-    emit start();
+    if(!sources)
+        return;
+    QStringList patterns = dsoSettings->scope.input.subscriptions;
+    for(unsigned channel = 0; channel < dsoSettings->scope.maxChannels && channel < dsoSettings->scope.voltage.size(); ++channel)
+    {
+        const DsoSettingsScopeVoltage& voltage = dsoSettings->scope.voltage[channel];
+        if(voltage.used && !voltage.selectedChannelName.isEmpty() && !patterns.contains(voltage.selectedChannelName))
+            patterns << voltage.selectedChannelName;
+    }
+    if(patterns != sources->subscription())
+    {
+        sources->setSubscription(patterns);
+        updateRetention(); // the memory budget is shared by the subscribed channels
+    }
 }
 
-SampleData *DsoInput::GetSampleData(const QString &name)
+void DsoInput::samplesAdded()
 {
-    if(sampleDatas.contains(name))
-        return sampleDatas[name];
-    SampleData* newData = new SampleData();
-    sampleDatas.insert(name, newData);
-    newData->name = name;
-    if(dsoSettings)
-    {
-        dsoSettings->scope.AvaliableChannelNames = sampleDatas.keys().toVector();
-        emit newChannelData(&dsoSettings->scope);
-    }
-    return newData;
+    if(framePending) // coalesce the notifications of all sources into one frame
+        return;
+    framePending = true;
+    QMetaObject::invokeMethod(this, "processLines", Qt::QueuedConnection);
 }
 
 unsigned DsoInput::getRecordLength() const
@@ -183,12 +145,14 @@ void DsoInput::enableSamplingUI(bool enabled)
 
 Dso::ErrorCode DsoInput::setSamplerate(double samplerate)
 {
-    result.samplerate = samplerate;
+    gridRate = samplerate;
     return Dso::ErrorCode::NONE;
 }
 
 Dso::ErrorCode DsoInput::setRecordTime(double duration)
 {
+    if(duration > 0)
+        recordTime = duration;
 return Dso::ErrorCode::NONE;
 }
 
@@ -251,81 +215,84 @@ void DsoInput::restartSampling()
 {
     if(!capturing)
         return;
-    if(!currFile.isReadable())
+    if(!sources)
     {
-        currFile.setFileName(filePath);
-        currFile.open(QIODevice::ReadOnly|QIODevice::Text);
-        cacheFilePosition = 0;
-        result.data.resize(4);
+        // created here and not in the constructor, the manager must live in the thread of this object
+        sources.reset(new SourceManager(verboseLevel));
+        connect(sources.get(), &SourceManager::samplesAdded, this, &DsoInput::samplesAdded);
+        connect(sources.get(), &SourceManager::channelsChanged, this, &DsoInput::channelsChanged);
+        connect(sources.get(), &SourceManager::statusMessage, this, &DsoInput::statusMessage);
+        updateSubscription(); // before the sources start, they parse nothing else
+        addSources();
     }
-    currFile.seek(cacheFilePosition);
-
-    int maxSize = 0;
-    while(!currFile.atEnd())
+    else
     {
-        QByteArray Line = currFile.readLine();
-        if(!Line.endsWith('\n'))
-            break;
-        cacheFilePosition = currFile.pos();
-
-        QString LineStr(Line);
-        if(isScopeData(LineStr))
-        {
-            QVector<QString> tokens = LexicalParser(LineStr);
-            AnalysedChannelData data = DataParser(tokens);
-            for(const auto& Pair : data.datas)
-            {
-                SampleData* sampleData = GetSampleData(Pair.first);
-                sampleData->addData(data.sampleTime, Pair.second, 1.0f / 60.0f);
-                maxSize = std::max(maxSize, (int)sampleData->data.size());
-            }
-        }
+        sources->refresh();
     }
+}
 
-    for(auto itr= sampleDatas.begin(); itr!=sampleDatas.end();++itr)
-    {
-        itr.value()->addEmptyData(maxSize);
-    }
+void DsoInput::processLines()
+{
+    framePending = false;
+    if(!capturing)
+        return;
 
-    for(unsigned channel = 0; channel < dsoSettings->scope.maxChannels; ++channel)
+    const int64_t buildStart = FrameTrace::now();
+    // nobody else reads this frame, the post processing works on an older one or waits for this one
+    DSOsamples* frame = mailbox.beginWrite();
+    frame->data.resize(dsoSettings->scope.voltage.size());
+    frame->startTime.resize(frame->data.size());
+    // every channel is resampled to the same grid, it ends at the newest sample of the source of the channel
+    frame->samplerate = gridSamplerate();
+    frame->sampleCount = frameSamples();
+    // more grid points than pixels: the graph draws the min/max envelope of a column, about one per pixel
+    const size_t columns = 2 * std::max(dsoSettings->view.screenWidth, 1024u);
+    frame->envelopeStride = std::max(frame->sampleCount / columns, size_t(1));
+    frame->tag = ++frameTag;
+    frame->stamps = FrameStamps(); // raised to the newest read and parsed times of the snapshot sources
+    const double interval = 1e9 / frame->samplerate;
+    const int64_t duration = int64_t(std::ceil((frame->sampleCount - 1) * interval));
+    for(unsigned channel = 0; channel < dsoSettings->scope.maxChannels && channel < frame->data.size(); ++channel)
     {
+        frame->data[channel].clear();
         if(dsoSettings->scope.voltage[channel].used)
         {
             QString dataName = dsoSettings->scope.voltage[channel].selectedChannelName;
-            if(!dataName.isEmpty())
-                result.data[channel] = &GetSampleData(dataName)->data;
+            int64_t end = 0;
+            if(!dataName.isEmpty() && sources->snapshot(dataName, duration, frame->data[channel], end, &frame->stamps))
+            {
+                // aligned to the grid, a steady signal is resampled to the same values in every frame
+                frame->startTime[channel] = int64_t(std::floor((end - duration) / interval) * interval);
+            }
         }
     }
-    emit samplesAvailable( &result );
-
-    QTimer::singleShot(acquireInterval, this, &DsoInput::restartSampling);
+    frame->stamps.built = FrameTrace::now();
+    FrameTrace::instance().span(buildStage, buildStart, frame->stamps.built, frame->tag);
+    if(mailbox.commit(frame)) // the post processing drains all pending frames per wake up
+        emit framesAvailable();
 }
 
-void SampleData::addData(float time, float value, float frameRate)
+void DsoInput::updateRetention()
 {
-    float interval = time - timeStamp;
-    int count = qRound(interval / frameRate);
-    if(count > 1)
+    const DsoSettingsScopeInput& input = dsoSettings->scope.input;
+    const size_t budgetBlocks = size_t(input.memoryBudget) * 1024 * 1024 / SampleBlockPool::blockBytes();
+    if(input.retentionSamples)
     {
-        double last = data.size() > 0 ? data[data.size()-1] : 0.0f;
-//        for(int i = 0; i< count-1;++i)
-//        {
-//            data.push_back(last);
-//        }
+        // the newest block is partially filled
+        const size_t maxBlocks = size_t(std::ceil(double(input.retentionSamples) / SampleBlock::capacity)) + 1;
+        sources->applyRetention(maxBlocks, budgetBlocks, 0);
     }
-    else if(count < 1)
-    {
+    else
+        sources->applyRetention(budgetBlocks, budgetBlocks, int64_t(input.retentionTime * 1e9));
+}
 
-    }
-    data.push_back(value);
-    timeStamp = time;
+double DsoInput::gridSamplerate() const
+{
+    return gridRate > 0 ? gridRate : 60.0;
 }
 
-void SampleData::addEmptyData(int num)
+size_t DsoInput::frameSamples() const
 {
-    float lastValue = data.empty() ? 0.0f : data[data.size() - 1];
-    while(data.size() + 1 < static_cast<size_t>(num))
-    {
-        data.push_back(lastValue);
-    }
+    // twice the screen, leaves room for the pre trigger part and the trigger search
+    return size_t(std::ceil(2 * recordTime * gridSamplerate())) + 1;
 }
@@ -1,23 +1,16 @@
 #ifndef DSOINPUT_H
 #define DSOINPUT_H
 
-#include <QFile>
 #include <QObject>
 #include <QSettings>
+#include <QTimer>
 #include <dsosettings.h>
+#include <memory>
 #include <triggering.h>
 
+#include "framemailbox.h"
+#include "sourcemanager.h"
 
-struct SampleData
-{
-public:
-    QString name = "";
-    std::vector<double> data;
-    float timeStamp = 0.0f;
-
-    void addData(float time, float value, float frameRate);
-    void addEmptyData(int num);
-};
 
 class DsoInput :public QObject
 {
@@ -53,14 +46,27 @@ public:
 
   void StartSample();
 
+  /// \brief The frames for the post processing, framesAvailable() tells when to take() them.
+  FrameMailbox &frames() { return mailbox; }
+
 private:
   DsoSettings *dsoSettings = nullptr;
-  SampleData* GetSampleData(const QString& name);
-  QMap<QString, SampleData*> sampleDatas;
-  QFile currFile;
-  int cacheFilePosition;
+  std::unique_ptr<SourceManager> sources; ///< One reader thread per followed log file
+  bool framePending = false;
+  QTimer *discoveryTimer = nullptr; ///< Batches the channel discoveries of all sources into one notification
+  double recordTime = 0.0; ///< Time span on screen, the snapshot handed out per frame covers twice of it
   int ElapsedTimeMS = 0;
 
+  /// \brief Apply the retention time/samples and the memory budget to all channel rings.
+  void updateRetention();
+  /// \brief Samplerate of the uniform grid the channels are resampled to.
+  double gridSamplerate() const;
+  /// \brief Number of grid points handed to the post processing per frame.
+  size_t frameSamples() const;
+
+  /// \brief Create a log source for every file of the input settings.
+  void addSources();
+
   bool bQuit = false;
   std::unique_ptr< Triggering > triggering;
   bool singleChannel = false;
@@ -88,7 +94,10 @@ private:
 
   // Results
   unsigned downsamplingNumber = 1; ///< Number of downsamples to reduce sample rate
-  DSOsamples result;
+  FrameMailbox mailbox;     ///< Hands the newest frames to the post processing, coalesces the stale ones
+  double gridRate = 0.0;    ///< Samplerate of the uniform grid, 0 until set
+  unsigned frameTag = 0;    ///< Tag of the last frame, the gaps of the processed tags are the coalesced frames
+  unsigned buildStage;      ///< FrameTrace stage of processLines()
   unsigned expectedSampleCount = 0; ///< The expected total number of samples at
                                     /// the last check before sampling started
   bool calibrationHasChanged = false;
@@ -99,15 +108,7 @@ private:
   bool samplingStarted = false;
   bool stateMachineRunning = false;
   int acquireInterval = 3;
-  int displayInterval = 0;
   unsigned activeChannels = 2;
-  bool refresh = false; // parameter changed -> new raw to result conversion and trigger search needed
-  void requestRefresh( bool active = true ) { refresh = active; }
-  bool refreshNeeded() {
-      bool changed = refresh;
-      refresh = false;
-      return changed;
-  }
 
   unsigned debugLevel = 0;
 
@@ -118,7 +119,10 @@ private:
   } while ( 0 )
 
 public slots:
-  /// \brief If sampling is disabled, no samplesAvailable() signals are send anymore, no samples
+  /// \brief Subscribe the configured patterns and the selected channels of all used voltage channels.
+  /// The values of the other channels are skipped by the sources, their names are still listed.
+  void updateSubscription();
+  /// \brief If sampling is disabled, no framesAvailable() signals are send anymore, no samples
   /// are fetched from the device and no processing takes place.
   /// \param enabled Enables/Disables sampling
   void enableSamplingUI( bool enabled = true );
@@ -195,12 +199,20 @@ public slots:
   /// \brief Starts a new sampling block.
   void restartSampling();
 
+private slots:
+  /// \brief Hand the newest samples of the selected channels to the post processing.
+  void processLines();
+  void samplesAdded();
+  void channelsChanged();
+  /// \brief Publish the merged channel names of all sources.
+  void publishChannels();
+
 signals:
   void newChannelData(const DsoSettingsScope* scope);
   void newChannelData2();
   void showSamplingStatus( bool enabled );                   ///< The oscilloscope started/stopped sampling/waiting for trigger
   void statusMessage( const QString &message, int timeout ); ///< Status message about the oscilloscope
-  void samplesAvailable( const DSOsamples *samples );        ///< New sample data is available
+  void framesAvailable();                                    ///< frames() has new frames, sent once per batch
   void start();
   void samplerateChanged( double samplerate ); ///< The samplerate has changed
 
@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <algorithm>
+
+#include <QMutexLocker>
+
+#include "framemailbox.h"
+
+
+FrameMailbox::FrameMailbox( size_t slots ) : slotCount( std::max( slots, size_t( 1 ) ) ) {
+    for ( size_t index = 0; index < slotCount + 2; ++index ) {
+        frames.emplace_back( new DSOsamples() );
+        idle.push_back( frames.back().get() );
+    }
+    pending.reserve( slotCount );
+}
+
+
+DSOsamples *FrameMailbox::beginWrite() {
+    QMutexLocker locker( &mutex );
+    if ( pending.size() < slotCount ) { // at least one frame is idle, the others are pending or in use
+        writing = idle.back();
+        idle.pop_back();
+    } else if ( slotCount == 1 ) { // latest wins, the pending frame is superseded by the new one
+        writing = pending.back();
+        pending.pop_back();
+        ++counters.coalesced;
+    } else { // keep the order, the oldest pending frame makes room
+        writing = pending.front();
+        pending.erase( pending.begin() );
+        ++counters.dropped;
+    }
+    return writing;
+}
+
+
+bool FrameMailbox::commit( DSOsamples *frame ) {
+    QMutexLocker locker( &mutex );
+    Q_ASSERT( frame == writing );
+    writing = nullptr;
+    pending.push_back( frame );
+    ++counters.posted;
+    if ( wakeRequested )
+        return false;
+    wakeRequested = true;
+    return true;
+}
+
+
+const DSOsamples *FrameMailbox::take() {
+    QMutexLocker locker( &mutex );
+    if ( reading ) {
+        clearFrame( reading );
+        idle.push_back( reading );
+        reading = nullptr;
+    }
+    if ( pending.empty() ) {
+        wakeRequested = false;
+        return nullptr;
+    }
+    reading = pending.front();
+    pending.erase( pending.begin() );
+    ++counters.delivered;
+    return reading;
+}
+
+
+FrameMailbox::Statistics FrameMailbox::statistics() const {
+    QMutexLocker locker( &mutex );
+    return counters;
+}
+
+
+// static
+void FrameMailbox::clearFrame( DSOsamples *frame ) {
+    for ( SampleSnapshot &snapshot : frame->data )
+        snapshot.clear();
+}
@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <QMutex>
+
+#include "dsosamples.h"
+
+
+/// \brief Bounded hand over of frames from DsoInput to the post processing.
+///
+/// The producer fills a frame that nobody else reads and commits it, the consumer takes the committed
+/// frames and processes them. A frame is never copied, the mailbox owns `slots + 2` frames that are
+/// recycled: `slots` pending ones, one that is written and one that is processed.
+/// If the consumer falls behind, the newest frame always gets in:
+/// - one slot (default): latest wins, a pending frame is replaced by the newer one (coalesced).
+/// - `slots` > 1: the pending frames are delivered in order, the oldest one is discarded if all slots
+///   are taken (dropped).
+/// The consumer has to be woken only once per batch, commit() tells when.
+class FrameMailbox {
+  public:
+    struct Statistics {
+        uint64_t posted = 0;    ///< Frames committed by the producer
+        uint64_t delivered = 0; ///< Frames taken by the consumer
+        uint64_t coalesced = 0; ///< Pending frames replaced by a newer one before they were taken
+        uint64_t dropped = 0;   ///< Oldest pending frames discarded to make room for a newer one
+    };
+
+    explicit FrameMailbox( size_t slots = 1 );
+    size_t slots() const { return slotCount; }
+
+    /// \brief Producer: a frame to fill, a free one or the pending one that is given up for it.
+    /// The snapshots of a recycled frame are kept, the producer overwrites them.
+    DSOsamples *beginWrite();
+    /// \brief Producer: make the frame of beginWrite() available.
+    /// \return true if the consumer has to be woken up, i.e. it has not been told about pending frames yet.
+    bool commit( DSOsamples *frame );
+
+    /// \brief Consumer: release the previously taken frame and take the next pending one.
+    /// \return nullptr if none is pending, the next commit() asks for a wake up again.
+    const DSOsamples *take();
+
+    /// \brief Consistent copy of the counters, may be called from any thread.
+    Statistics statistics() const;
+
+  private:
+    /// \brief Give up a frame, its snapshots no longer pin the sample blocks.
+    static void clearFrame( DSOsamples *frame );
+
+    const size_t slotCount;
+    std::vector< std::unique_ptr< DSOsamples > > frames; ///< Owns all frames
+    std::vector< DSOsamples * > idle;                    ///< Neither pending nor in use
+    std::vector< DSOsamples * > pending;                 ///< Committed, oldest first, never reallocated
+    DSOsamples *writing = nullptr;                       ///< Handed out by beginWrite()
+    DSOsamples *reading = nullptr;                       ///< Handed out by take()
+    bool wakeRequested = false;                          ///< The consumer has been told and not drained yet
+    Statistics counters;
+    mutable QMutex mutex;
+};
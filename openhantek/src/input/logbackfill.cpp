@@ -0,0 +1,263 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#include <QDebug>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include "logbackfill.h"
+#include "logtailer.h"
+#include "scopedataparser.h"
+
+
+// History bytes per chunk, large enough to keep the per chunk overhead small, small enough for a fast first trace
+static const qint64 chunkSize = 32 << 20;
+// Bytes read at once while searching a line boundary
+static const qint64 searchSize = 64 << 10;
+// Chunks queued ahead of the chunk handler, enough to keep the pool busy with a single backfill
+static size_t chunkWindow() { return size_t( std::max( 2, QThread::idealThreadCount() ) ); }
+
+
+/// \brief State shared by the workers and the LogBackfill, the workers may outlive a cancel().
+struct LogBackfill::Shared {
+    QString fileName;
+    QByteArray key;
+    ScopeDataParser::Subscription subscription;
+    QMutex mutex;
+    std::vector< std::unique_ptr< Chunk > > chunks; ///< Newest first
+    std::vector< bool > done;                       ///< Guarded by mutex
+    std::atomic< bool > cancelled{ false };
+    int queued = 0;                                 ///< Workers in the pool, queued or running, guarded by mutex
+    QWaitCondition idle;                            ///< Signalled when `queued` drops to 0
+};
+
+
+/// \brief Scans and parses one chunk with its own parser.
+class LogBackfill::Worker : public QRunnable {
+  public:
+    Worker( std::shared_ptr< Shared > shared, size_t index, LogBackfill *owner )
+        : shared( std::move( shared ) ), index( index ), owner( owner ) {}
+
+    void run() override {
+        if ( !shared->cancelled ) {
+            parse( *shared->chunks[ index ] );
+            {
+                QMutexLocker locker( &shared->mutex );
+                shared->done[ index ] = true;
+            }
+            // the owner waits for its workers in its destructor, it is still alive here
+            QMetaObject::invokeMethod( owner, "collect", Qt::QueuedConnection );
+        }
+        QMutexLocker locker( &shared->mutex );
+        if ( 0 == --shared->queued )
+            shared->idle.wakeAll();
+    }
+
+  private:
+    void parse( Chunk &chunk ) {
+        QFile file( shared->fileName );
+        if ( !file.open( QIODevice::ReadOnly ) )
+            return;
+        qint64 size = chunk.end - chunk.begin;
+        QByteArray buffer;
+        const char *data;
+        uchar *mapped = file.map( chunk.begin, size );
+        if ( mapped )
+            data = reinterpret_cast< const char * >( mapped );
+        else {
+            if ( !file.seek( chunk.begin ) )
+                return;
+            buffer = file.read( size );
+            data = buffer.constData();
+            size = buffer.size();
+        }
+        ScopeDataParser parser;
+        parser.setSubscription( shared->subscription );
+        ScopeDataParser::Line line;
+        std::vector< Column > &columns = chunk.columns; // indexed by the channel id of this chunk's parser
+        int matches = 0;
+        qint64 nextIndexed = chunk.begin;
+        LogTailer::scanLines( data, size, shared->key,
+                              [ & ]( const char *begin, const char *end ) {
+                                  if ( !parser.parse( begin, end, line ) )
+                                      return;
+                                  const int64_t time = std::llround( line.time * 1e9 );
+                                  if ( chunk.begin + ( begin - data ) >= nextIndexed ) {
+                                      const qint64 offset = chunk.begin + ( LogTailer::lineBegin( data, begin ) - data );
+                                      chunk.index.push_back( { offset, time } );
+                                      nextIndexed = offset + LogTimeIndex::stride;
+                                  }
+                                  for ( const ScopeDataParser::Value &value : line.values ) {
+                                      if ( value.channel >= columns.size() )
+                                          columns.resize( value.channel + 1 );
+                                      Column &column = columns[ value.channel ];
+                                      if ( column.name.empty() )
+                                          column.name = parser.channelName( value.channel );
+                                      // kept ascending like SampleData::addData() does it
+                                      column.times.push_back( column.times.empty() ? time : std::max( time, column.times.back() ) );
+                                      column.values.push_back( value.value );
+                                  }
+                              },
+                              chunk.lines, matches );
+        // the names of the unsubscribed channels are listed too, with empty columns
+        if ( columns.size() < parser.channelCount() )
+            columns.resize( parser.channelCount() );
+        for ( unsigned channel = 0; channel < columns.size(); ++channel )
+            if ( columns[ channel ].name.empty() )
+                columns[ channel ].name = parser.channelName( channel );
+        if ( mapped )
+            file.unmap( mapped );
+    }
+
+    std::shared_ptr< Shared > shared;
+    size_t index;
+    LogBackfill *owner;
+};
+
+
+// Offset of the first line that starts at or after `position`, `limit` if there is none before it
+static qint64 nextLineStart( QFile &file, qint64 position, qint64 limit ) {
+    for ( qint64 pos = position - 1; pos < limit; pos += searchSize ) { // a line starts after the newline at pos
+        if ( !file.seek( pos ) )
+            break;
+        const QByteArray buffer = file.read( qMin( searchSize, limit - pos ) );
+        if ( buffer.isEmpty() )
+            break;
+        const int newline = buffer.indexOf( '\n' );
+        if ( newline >= 0 )
+            return pos + newline + 1;
+    }
+    return limit;
+}
+
+
+// Offset after the last newline before `size`, 0 if there is none
+static qint64 lastLineEnd( QFile &file, qint64 size ) {
+    for ( qint64 end = size; end > 0; ) {
+        const qint64 begin = qMax( qint64( 0 ), end - searchSize );
+        if ( !file.seek( begin ) )
+            break;
+        const QByteArray buffer = file.read( end - begin );
+        const int newline = buffer.lastIndexOf( '\n' );
+        if ( newline >= 0 )
+            return begin + newline + 1;
+        end = begin;
+    }
+    return 0;
+}
+
+
+LogBackfill::LogBackfill( const QString &fileName, const QByteArray &key, int verboseLevel, QObject *parent )
+    : QObject( parent ), logFileName( fileName ), key( key ), verboseLevel( verboseLevel ),
+      shared( std::make_shared< Shared >() ) {
+    shared->fileName = fileName;
+    shared->key = key;
+}
+
+
+LogBackfill::~LogBackfill() {
+    cancel(); // the queued workers return at once
+    QMutexLocker locker( &shared->mutex );
+    while ( shared->queued )
+        shared->idle.wait( &shared->mutex );
+}
+
+
+void LogBackfill::setSubscription( ScopeDataParser::Subscription subscription ) {
+    shared->subscription = std::move( subscription );
+}
+
+
+qint64 LogBackfill::prepare( qint64 begin, qint64 size ) {
+    QFile file( logFileName );
+    if ( !file.open( QIODevice::ReadOnly ) )
+        return begin;
+    historyBegin = begin;
+    historySize = qMax( begin, lastLineEnd( file, size ) );
+    std::vector< qint64 > boundaries( 1, begin );
+    for ( qint64 position = begin + chunkSize; position < historySize; position += chunkSize ) {
+        const qint64 boundary = nextLineStart( file, position, historySize );
+        if ( boundary > boundaries.back() && boundary < historySize )
+            boundaries.push_back( boundary );
+    }
+    boundaries.push_back( historySize );
+    shared->chunks.clear();
+    for ( size_t index = boundaries.size() - 1; index > 0; --index ) { // newest first
+        std::unique_ptr< Chunk > chunk( new Chunk );
+        chunk->begin = boundaries[ index - 1 ];
+        chunk->end = boundaries[ index ];
+        shared->chunks.push_back( std::move( chunk ) );
+    }
+    shared->done.assign( shared->chunks.size(), false );
+    if ( verboseLevel > 1 )
+        qDebug() << "  LogBackfill::prepare()" << logFileName << historySize - begin << "bytes," << shared->chunks.size()
+                 << "chunks";
+    return historySize;
+}
+
+
+void LogBackfill::start() {
+    timer.start();
+    nextChunk = 0;
+    nextQueued = 0;
+    queueChunks();
+    collect(); // finishes at once if there is no history
+}
+
+
+void LogBackfill::queueChunks() {
+    // queued in order, the newest is parsed first, a chunk is parsed only shortly before the handler needs it
+    const size_t end = std::min( shared->chunks.size(), nextChunk + chunkWindow() );
+    for ( ; !shared->cancelled && nextQueued < end; ++nextQueued ) {
+        {
+            QMutexLocker locker( &shared->mutex );
+            ++shared->queued;
+        }
+        QThreadPool::globalInstance()->start( new Worker( shared, nextQueued, this ) );
+    }
+}
+
+
+void LogBackfill::cancel() {
+    shared->cancelled = true; // no more chunks are queued, the queued ones return at once
+}
+
+
+void LogBackfill::collect() {
+    while ( !finished && nextChunk < shared->chunks.size() ) {
+        std::unique_ptr< Chunk > chunk;
+        {
+            QMutexLocker locker( &shared->mutex );
+            if ( !shared->done[ nextChunk ] ) // keep the order, wait for this one
+                break;
+            chunk = std::move( shared->chunks[ nextChunk ] );
+        }
+        ++nextChunk;
+        handledBytes += chunk->end - chunk->begin;
+        handledLines += chunk->lines;
+        const bool more = chunkHandler ? chunkHandler( *chunk ) : true;
+        if ( !more ) {
+            if ( verboseLevel > 1 )
+                qDebug() << "  LogBackfill::collect() older history is not needed," << chunk->begin << "bytes skipped";
+            cancel();
+            nextChunk = shared->chunks.size();
+            handledBytes = historySize - historyBegin;
+        }
+        emit progressChanged( handledBytes, historySize - historyBegin );
+    }
+    queueChunks();
+    if ( !finished && nextChunk == shared->chunks.size() ) {
+        finished = true;
+        if ( verboseLevel > 1 )
+            qDebug() << "  LogBackfill::collect()" << logFileName << handledLines << "lines in" << timer.elapsed() << "ms";
+        emit backfillFinished( handledLines, timer.elapsed() );
+    }
+}
@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QObject>
+#include <QString>
+
+#include "logtimeindex.h"
+#include "scopedataparser.h"
+
+
+/// \brief Loads the history of a large log file in parallel while the LogTailer already follows its end.
+///
+/// The existing part of the file is split into line aligned chunks that are scanned and parsed on the global thread
+/// pool, shared by the backfills of all sources, each chunk with its own parser into per channel columns (time stamps
+/// and values). The parsed chunks are handed to the chunk handler in the thread of this object, strictly from the
+/// newest to the oldest one, so the receiver can insert each one in front of the data it already has.
+/// Only a few chunks ahead of the handler are queued, chunks beyond the retention are not parsed at all.
+class LogBackfill : public QObject {
+    Q_OBJECT
+
+  public:
+    /// \brief The samples of one channel in one chunk, time stamps (ns) in ascending order.
+    /// The column of a channel that is not subscribed has a name but no samples.
+    struct Column {
+        std::string name;
+        std::vector< int64_t > times;
+        std::vector< double > values;
+    };
+    struct Chunk {
+        qint64 begin = 0; ///< Byte range of the chunk in the file
+        qint64 end = 0;
+        qint64 lines = 0;
+        std::vector< Column > columns;
+        std::vector< LogTimeIndex::Entry > index; ///< Sparse line offsets and time stamps of the chunk
+    };
+    /// \brief Called for every parsed chunk, newest first.
+    /// \return false if older chunks are not needed, e.g. because they are out of the retention time.
+    typedef std::function< bool( const Chunk &chunk ) > ChunkHandler;
+
+    LogBackfill( const QString &fileName, const QByteArray &key, int verboseLevel = 0, QObject *parent = nullptr );
+    /// \brief Cancels the chunks that are not yet parsed and waits for the queued and running ones.
+    ~LogBackfill() override;
+
+    /// \brief Split the bytes [`begin`, `size`) of the file into line aligned chunks.
+    /// \param begin Start of a line, e.g. the end of the part that is already cached.
+    /// \return The end of the last complete line within `size`, the live tail starts there.
+    qint64 prepare( qint64 begin, qint64 size );
+    /// \brief Start parsing, the newest chunk first.
+    void start();
+    void cancel();
+    bool isFinished() const { return finished; }
+
+    void setChunkHandler( ChunkHandler handler ) { chunkHandler = std::move( handler ); }
+    /// \brief Parse only the subscribed channels, set before start(). It is called from the pool threads.
+    void setSubscription( ScopeDataParser::Subscription subscription );
+
+  signals:
+    /// \param done Bytes of the history that were handed to the chunk handler (or skipped).
+    void progressChanged( qint64 done, qint64 total );
+    /// All chunks are handled or the rest was cancelled.
+    void backfillFinished( qint64 lines, qint64 msecs );
+
+  private slots:
+    /// \brief Hand the parsed chunks in order to the chunk handler, called whenever a worker is done.
+    void collect();
+
+  private:
+    /// \brief Queue the workers of the chunks within the window ahead of the handler.
+    void queueChunks();
+
+    struct Shared;
+    class Worker;
+
+    QString logFileName;
+    QByteArray key;
+    int verboseLevel = 0;
+    ChunkHandler chunkHandler;
+    std::shared_ptr< Shared > shared;
+    qint64 historyBegin = 0;
+    qint64 historySize = 0;
+    qint64 handledBytes = 0;
+    qint64 handledLines = 0;
+    size_t nextChunk = 0;  ///< Index into Shared::chunks of the next chunk for the handler, counted from the newest
+    size_t nextQueued = 0; ///< Index into Shared::chunks of the next chunk for the pool
+    bool finished = false;
+    QElapsedTimer timer;
+};
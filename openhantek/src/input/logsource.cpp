@@ -0,0 +1,404 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+#include "logsource.h"
+
+
+static const QByteArray KeyTemplate = "ScopeData: ";
+// Existing files larger than this are loaded in parallel chunks while the tail is already followed
+static const qint64 backfillThreshold = 16 << 20;
+// The samples parsed by the tailer are written to the sidecar in segments of this many samples or milliseconds
+static const size_t cacheFlushSamples = 1 << 16;
+static const qint64 cacheFlushInterval = 2000;
+
+
+LogSource::LogSource( const QString &fileName, const QString &prefix, bool useCache, int verboseLevel )
+    : SampleSource( prefix, verboseLevel ), logFileName( fileName ), useCache( useCache ) {}
+
+
+LogSource::~LogSource() = default;
+
+
+void LogSource::start() {
+    if ( tailer )
+        return;
+    // created here and not in the constructor, the tailer and its file watcher must live in the thread of the source
+    tailer.reset( new LogTailer( KeyTemplate ) );
+    liveSubscription = subscription();
+    parser.setSubscription( liveSubscription ); // values of other channels are skipped at the byte level
+    tailer->setLineHandler( [ this ]( const char *begin, const char *end ) { parseLine( begin, end ); } );
+    connect( tailer.get(), &LogTailer::linesAvailable, this, &LogSource::processLines );
+    connect( tailer.get(), &LogTailer::statisticsChanged, this, &LogSource::reportStatistics );
+    connect( tailer.get(), &LogTailer::restarted, this, &LogSource::fileRestarted );
+    qint64 livePosition = 0;
+    if ( useCache ) {
+        cache.reset( new SidecarCache( verboseLevel ) );
+        livePosition = cache->open( logFileName ); // only the text after the cached part is parsed
+    }
+    const qint64 size = QFileInfo( logFileName ).size();
+    if ( size - livePosition > backfillThreshold ) {
+        backfill.reset( new LogBackfill( logFileName, KeyTemplate, verboseLevel ) );
+        backfillSubscription = subscription();
+        backfill->setSubscription( backfillSubscription );
+        backfill->setChunkHandler( [ this ]( const LogBackfill::Chunk &chunk ) { return mergeChunk( chunk ); } );
+        connect( backfill.get(), &LogBackfill::progressChanged, this, &LogSource::reportProgress );
+        connect( backfill.get(), &LogBackfill::backfillFinished, this, &LogSource::backfillFinished );
+        livePosition = backfill->prepare( livePosition, size );
+    }
+    if ( !tailer->open( logFileName, livePosition ) ) {
+        emit statusMessage( tr( "Could not open %1" ).arg( logFileName ), 0 );
+        if ( verboseLevel > 1 )
+            qDebug() << "  LogSource::start() could not open" << logFileName;
+        backfill.reset();
+        cache.reset();
+        return;
+    }
+    cacheBegin = livePosition;
+    cacheTimer.start();
+    tailer->poll();
+    cachePending = cache && !cache->segments().empty();
+    if ( backfill )
+        backfill->start(); // the cached segments are older than the backfill, they are inserted after it
+    else if ( cachePending )
+        loadCache();
+}
+
+
+void LogSource::stop() {
+    backfill.reset(); // cancels the history chunks that are not yet parsed
+    if ( cache && tailer )
+        flushCache();
+    cache.reset();
+    tailer.reset();
+}
+
+
+void LogSource::refresh() {
+    if ( !tailer )
+        return;
+    if ( !tailer->isOpen() )
+        tailer->open( logFileName );
+    tailer->poll();
+}
+
+
+void LogSource::parseLine( const char *begin, const char *end ) {
+    if ( !parser.parse( begin, end, parsedLine ) )
+        return;
+    const int64_t time = std::llround( parsedLine.time * 1e9 ); // the log has seconds, the channels ns
+    QMutexLocker locker( &mutex ); // uncontended unless a frame snapshot is taken right now
+    if ( timeIndex.wants( tailer->offsetOf( begin ) ) )
+        timeIndex.add( tailer->lineOffset( begin ), time );
+    for ( ; knownChannels < parser.channelCount(); ++knownChannels ) // list the new names, also unsubscribed ones
+        if ( !channel( knownChannels ) )
+            addChannel( knownChannels, QString::fromStdString( parser.channelName( knownChannels ) ) );
+    for ( const ScopeDataParser::Value &value : parsedLine.values ) {
+        SampleData *sampleData = channel( value.channel );
+        if ( !sampleData ) // first appearance of this channel name
+            sampleData = addChannel( value.channel, QString::fromStdString( parser.channelName( value.channel ) ) );
+        sampleData->addData( time, value.value );
+        if ( cache ) {
+            if ( value.channel >= cacheColumns.size() )
+                cacheColumns.resize( value.channel + 1 );
+            LogBackfill::Column &column = cacheColumns[ value.channel ];
+            if ( column.name.empty() )
+                column.name = parser.channelName( value.channel );
+            column.times.push_back( sampleData->data.backTime() ); // as stored, i.e. clamped
+            column.values.push_back( value.value );
+            ++cacheSamples;
+        }
+    }
+}
+
+
+void LogSource::flushCache() {
+    const qint64 position = tailer->position();
+    if ( position == cacheBegin )
+        return;
+    cache->append( cacheBegin, position, cacheColumns, parsedNames( liveSubscription ) );
+    for ( LogBackfill::Column &column : cacheColumns ) { // the names and the capacity are kept
+        column.times.clear();
+        column.values.clear();
+    }
+    cacheSamples = 0;
+    cacheBegin = position;
+    cacheTimer.restart();
+}
+
+
+std::vector< std::string > LogSource::parsedNames( const ScopeDataParser::Subscription &subscription ) const {
+    std::vector< std::string > names;
+    for ( unsigned id = 0; id < parser.channelCount(); ++id ) {
+        const std::string name = parser.channelName( id );
+        if ( !subscription || subscription( name.data(), name.size() ) )
+            names.push_back( name );
+    }
+    return names;
+}
+
+
+SampleData *LogSource::namedChannel( const char *name, size_t nameSize ) {
+    // the channel ids of other parsers are mapped by name to the ids of the live parser
+    const unsigned id = parser.intern( name, nameSize );
+    SampleData *sampleData = channel( id );
+    if ( !sampleData )
+        sampleData = addChannel( id, QString::fromUtf8( name, int( nameSize ) ) );
+    return sampleData;
+}
+
+
+long LogSource::prependColumn( const char *name, size_t nameSize, const int64_t *times, const double *values, size_t count ) {
+    SampleData *sampleData = namedChannel( name, nameSize );
+    if ( !sampleData->subscribed )
+        return -1;
+    return long( sampleData->data.prepend( times, values, count ) );
+}
+
+
+void LogSource::loadCache() {
+    cachePending = false;
+    QElapsedTimer timer;
+    timer.start();
+    size_t loaded = 0;
+    const std::vector< SidecarCache::SegmentView > &segments = cache->segments();
+    const qint64 runEnd = segments.empty() ? 0 : segments.front().end;
+    // the cached history of a channel is used as far as it is contiguous from the newest segment downwards
+    struct Coverage {
+        qint64 from;       ///< Log offset the loaded history of the channel starts at
+        bool gap = false;  ///< The older segments lack the channel, its history is re-scanned from `from`
+        bool full = false; ///< The retention of the channel is reached
+    };
+    std::map< std::string, Coverage > coverage;
+    for ( const SidecarCache::SegmentView &segment : segments ) { // newest first
+        bool needed = true; // unless all subscribed channels are saturated
+        {
+            QMutexLocker locker( &mutex );
+            int64_t oldest = std::numeric_limits< int64_t >::max(); // a segment starts with a line, index it
+            for ( const SidecarCache::ColumnView &column : segment.columns )
+                if ( column.count )
+                    oldest = std::min( oldest, column.times[ 0 ] );
+            if ( oldest < std::numeric_limits< int64_t >::max() )
+                timeIndex.insert( { { segment.begin, oldest } } );
+            for ( const SidecarCache::ColumnView &column : segment.columns ) {
+                const std::string name( column.name, column.nameSize );
+                if ( rescanNames.count( name ) ) // subscribed during the backfill, its samples start later
+                    continue;
+                Coverage &covered = coverage.emplace( name, Coverage{ runEnd } ).first->second;
+                if ( covered.gap || covered.full || segment.begin >= covered.from ) // or cached by an overlay already
+                    continue;
+                if ( segment.end < covered.from ) {
+                    covered.gap = true;
+                    continue;
+                }
+                covered.from = segment.begin;
+                if ( !column.count ) { // parsed from this range, but no samples
+                    namedChannel( column.name, column.nameSize );
+                    continue;
+                }
+                const long stored = prependColumn( column.name, column.nameSize, column.times, column.values, column.count );
+                if ( stored >= 0 ) {
+                    needed = needed && stored > 0;
+                    covered.full = size_t( stored ) < column.count;
+                }
+            }
+        }
+        ++loaded;
+        if ( !needed ) // older segments are out of the retention as well
+            break;
+    }
+    cache->releaseSegments();
+    if ( backfillOnSubscribe ) { // the parts of the log that are not cached for a subscribed channel are re-scanned
+        QMutexLocker locker( &mutex );
+        for ( unsigned id = 0; id < parser.channelCount(); ++id ) {
+            const SampleData *sampleData = channel( id );
+            const std::string name = parser.channelName( id );
+            if ( !sampleData || !sampleData->subscribed || rescanNames.count( name ) )
+                continue;
+            const auto covered = coverage.find( name );
+            if ( covered != coverage.end() && covered->second.full )
+                continue;
+            const qint64 from = covered != coverage.end() ? covered->second.from : runEnd;
+            if ( from > 0 )
+                rescanNames[ name ] = from;
+        }
+    }
+    if ( !rescanNames.empty() )
+        QMetaObject::invokeMethod( this, "startRescan", Qt::QueuedConnection );
+    publish();
+    emit statusMessage( tr( "%1: %2 cached segments loaded in %3 ms" ).arg( prefix() ).arg( loaded ).arg( timer.elapsed() ), 5000 );
+}
+
+
+bool LogSource::mergeChunk( const LogBackfill::Chunk &chunk ) {
+    bool needed = false;
+    bool subscribed = false;
+    {
+        QMutexLocker locker( &mutex );
+        timeIndex.insert( chunk.index );
+        for ( const LogBackfill::Column &column : chunk.columns ) {
+            if ( column.times.empty() ) { // an unsubscribed channel, only its name is listed
+                namedChannel( column.name.data(), column.name.size() );
+                continue;
+            }
+            const long stored = prependColumn( column.name.data(), column.name.size(), column.times.data(),
+                                               column.values.data(), column.times.size() );
+            subscribed = subscribed || stored >= 0;
+            needed = needed || stored > 0;
+        }
+    }
+    needed = needed || !subscribed; // no sample of a subscribed channel in this chunk, older ones may have some
+    if ( cache ) // the next session starts with this chunk from the sidecar, a re-scan adds its channels to it
+        cache->append( chunk.begin, chunk.end, chunk.columns, parsedNames( backfillSubscription ), rescanning );
+    publish();
+    return needed;
+}
+
+
+void LogSource::processLines() {
+    if ( cache && ( cacheSamples >= cacheFlushSamples || cacheTimer.elapsed() >= cacheFlushInterval ) )
+        flushCache();
+    publish( tailer->pollTime() );
+}
+
+
+void LogSource::reportProgress( qint64 done, qint64 total ) {
+    const int percent = total ? int( done * 100 / total ) : 100;
+    if ( percent == reportedProgress )
+        return;
+    reportedProgress = percent;
+    emit statusMessage( tr( "%1: loading history %2%" ).arg( prefix() ).arg( percent ), 0 );
+}
+
+
+void LogSource::backfillFinished( qint64 lines, qint64 msecs ) {
+    emit statusMessage( tr( "%1: history loaded, %2 lines in %3 s" ).arg( prefix() ).arg( lines ).arg( msecs / 1e3, 0, 'f', 1 ),
+                        5000 );
+    if ( cachePending )
+        loadCache();
+    rescanning = false;
+    if ( !rescanNames.empty() ) // subscribed while this backfill was running
+        QMetaObject::invokeMethod( this, "startRescan", Qt::QueuedConnection );
+}
+
+
+qint64 LogSource::offsetAt( int64_t time ) const {
+    QMutexLocker locker( &mutex );
+    return timeIndex.offsetAt( time );
+}
+
+
+void LogSource::fileRestarted( bool rotated ) {
+    backfill.reset(); // its byte ranges refer to the old content
+    rescanning = false;
+    rescanNames.clear();
+    cachePending = false;
+    {
+        QMutexLocker locker( &mutex );
+        timeIndex.clear();
+    }
+    if ( cache ) { // the samples of the old content stay in the channels but not in the sidecar
+        cache->discard( logFileName );
+        for ( LogBackfill::Column &column : cacheColumns ) {
+            column.times.clear();
+            column.values.clear();
+        }
+        cacheSamples = 0;
+        cacheTimer.restart();
+    }
+    cacheBegin = 0;
+    if ( verboseLevel > 1 )
+        qDebug() << "  LogSource::fileRestarted()" << logFileName << ( rotated ? "rotated" : "truncated" );
+    emit statusMessage( ( rotated ? tr( "%1 was rotated, following the new file" )
+                                  : tr( "%1 was truncated, following it from the start" ) )
+                            .arg( logFileName ),
+                        5000 );
+}
+
+
+void LogSource::subscriptionChanged( const QStringList &newlySubscribed ) {
+    if ( !tailer ) // not yet started, start() applies the subscription
+        return;
+    if ( cache && tailer->isOpen() ) // a cached segment is parsed with one subscription
+        flushCache();
+    liveSubscription = subscription();
+    parser.setSubscription( liveSubscription );
+    if ( !backfillOnSubscribe || newlySubscribed.isEmpty() || !tailer->isOpen() )
+        return;
+    {
+        // the live samples start at the tail position, the history in front of them is re-scanned
+        QMutexLocker locker( &mutex );
+        for ( const QString &name : newlySubscribed ) {
+            const std::string key = name.toStdString();
+            if ( SampleData *sampleData = channel( parser.find( key.data(), key.size() ) ) )
+                sampleData->data.clear(); // older samples of an earlier subscription, the part in between is missing
+            rescanNames[ key ] = tailer->position();
+        }
+    }
+    if ( !backfill || backfill->isFinished() )
+        QMetaObject::invokeMethod( this, "startRescan", Qt::QueuedConnection );
+}
+
+
+void LogSource::startRescan() {
+    if ( rescanNames.empty() || ( backfill && !backfill->isFinished() ) || !tailer || !tailer->isOpen() )
+        return;
+    // the channels whose stored samples start at the newest offset, the others follow in later re-scans
+    qint64 end = 0;
+    for ( const auto &pending : rescanNames )
+        end = std::max( end, pending.second );
+    std::set< std::string > names;
+    for ( auto pending = rescanNames.begin(); pending != rescanNames.end(); ) {
+        if ( pending->second == end ) {
+            names.insert( pending->first );
+            pending = rescanNames.erase( pending );
+        } else
+            ++pending;
+    }
+    qint64 begin = 0;
+    {
+        QMutexLocker locker( &mutex );
+        if ( retention() > 0 && newestTime() > std::numeric_limits< int64_t >::min() + retention() )
+            begin = timeIndex.offsetAt( newestTime() - retention() ); // older samples would be evicted at once
+    }
+    if ( begin >= end ) { // nothing within the retention
+        if ( !rescanNames.empty() )
+            QMetaObject::invokeMethod( this, "startRescan", Qt::QueuedConnection );
+        return;
+    }
+    if ( verboseLevel > 1 )
+        qDebug() << "  LogSource::startRescan()" << prefix() << names.size() << "channels from" << begin << "to" << end;
+    backfill.reset( new LogBackfill( logFileName, KeyTemplate, verboseLevel ) );
+    backfillSubscription = [ names ]( const char *name, size_t length ) {
+        return names.count( std::string( name, length ) ) > 0;
+    };
+    backfill->setSubscription( backfillSubscription );
+    backfill->setChunkHandler( [ this ]( const LogBackfill::Chunk &chunk ) { return mergeChunk( chunk ); } );
+    connect( backfill.get(), &LogBackfill::progressChanged, this, &LogSource::reportProgress );
+    connect( backfill.get(), &LogBackfill::backfillFinished, this, &LogSource::backfillFinished );
+    rescanning = true;
+    reportedProgress = -1;
+    backfill->prepare( begin, end );
+    backfill->start();
+}
+
+
+void LogSource::reportStatistics( const LogTailer::Statistics &statistics ) {
+    emit statusMessage( tr( "%1: %2 kB/s, %3 lines/s, %4 ScopeData/s (scan %5 MB/s)" )
+                            .arg( prefix() )
+                            .arg( statistics.bytesPerSecond / 1e3, 0, 'f', 1 )
+                            .arg( statistics.linesPerSecond, 0, 'f', 0 )
+                            .arg( statistics.matchesPerSecond, 0, 'f', 0 )
+                            .arg( statistics.scanBytesPerSecond / 1e6, 0, 'f', 0 ),
+                        2000 );
+    if ( verboseLevel > 2 )
+        qDebug() << "  LogSource::reportStatistics()" << prefix() << statistics.bytesPerSecond << "B/s"
+                 << statistics.linesPerSecond << "lines/s" << statistics.matchesPerSecond << "matches/s"
+                 << statistics.scanBytesPerSecond << "B/s scan";
+}
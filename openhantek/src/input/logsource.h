@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <QElapsedTimer>
+
+#include "logbackfill.h"
+#include "logtailer.h"
+#include "logtimeindex.h"
+#include "samplesource.h"
+#include "scopedataparser.h"
+#include "sidecarcache.h"
+
+
+/// \brief Follows one log file and collects the values of all "ScopeData: " lines per channel name.
+/// Each log source has its own tailer and parser state and runs in its own thread.
+/// The history of a large file is loaded by a LogBackfill in parallel, the tailer starts at the end of the file at once.
+/// The parsed samples are also written to a SidecarCache, a reopened log is parsed as text only after the cached part.
+/// A sparse LogTimeIndex maps time stamps to byte offsets of the log, e.g. to jump into a multi-GB log.
+class LogSource : public SampleSource {
+    Q_OBJECT
+
+  public:
+    /// \param useCache Load and extend the sidecar cache of the log.
+    LogSource( const QString &fileName, const QString &prefix, bool useCache = true, int verboseLevel = 0 );
+    ~LogSource() override;
+
+    const QString &fileName() const { return logFileName; }
+    /// \brief Re-scan the file for the history of channels that are subscribed later, set before start().
+    void setBackfillOnSubscribe( bool enable ) { backfillOnSubscribe = enable; }
+    /// \brief Thread safe, start of a line at or before `time` (ns), scanning the log from there reaches `time`.
+    /// Only the parsed or cached part of the log is indexed, 0 if `time` is before it.
+    qint64 offsetAt( int64_t time ) const;
+
+  public slots:
+    void start() override;
+    void stop() override;
+    void refresh() override;
+
+  private slots:
+    void processLines();
+    void reportStatistics( const LogTailer::Statistics &statistics );
+    void reportProgress( qint64 done, qint64 total );
+    void backfillFinished( qint64 lines, qint64 msecs );
+    /// \brief The log was truncated or rotated, drop everything that refers to the old content.
+    void fileRestarted( bool rotated );
+    /// \brief Load the history in front of the stored samples of the channels in `rescanNames`, one re-scan for
+    /// the channels whose stored samples start at the same log offset.
+    void startRescan();
+
+  protected:
+    void subscriptionChanged( const QStringList &newlySubscribed ) override;
+
+  private:
+    /// \brief Parse one "ScopeData: " line, called by the tailer with the bytes after the key.
+    void parseLine( const char *begin, const char *end );
+    /// \brief Insert a parsed history chunk in front of the channels.
+    /// \return false if no sample of the chunk was needed, older chunks are not needed either.
+    bool mergeChunk( const LogBackfill::Chunk &chunk );
+    /// \brief Insert the cached segments in front of the channels, newest first.
+    void loadCache();
+    /// \brief Return the channel `name`, it is added if it is new. Called with `mutex` held.
+    SampleData *namedChannel( const char *name, size_t nameSize );
+    /// \brief Insert older samples of the channel `name` in front of it, called with `mutex` held.
+    /// \return The number of samples stored, -1 if the channel is not subscribed.
+    long prependColumn( const char *name, size_t nameSize, const int64_t *times, const double *values, size_t count );
+    /// \brief Write the samples parsed by the tailer since the last call to the sidecar.
+    void flushCache();
+    /// \brief The known channels that are parsed with `subscription`, a range parsed with it is complete for them.
+    std::vector< std::string > parsedNames( const ScopeDataParser::Subscription &subscription ) const;
+
+    QString logFileName;
+    std::unique_ptr< LogTailer > tailer;
+    std::unique_ptr< LogBackfill > backfill;
+    int reportedProgress = -1; ///< Percent
+    bool backfillOnSubscribe = true;
+    bool rescanning = false; ///< The backfill is a re-scan for newly subscribed channels
+    /// Subscribed channels that wait for their history, by the log offset their stored samples start at
+    std::map< std::string, qint64 > rescanNames;
+    ScopeDataParser::Subscription liveSubscription;     ///< Of `parser`
+    ScopeDataParser::Subscription backfillSubscription; ///< Of the current backfill or re-scan
+    LogTimeIndex timeIndex;              ///< Guarded by `mutex`
+    std::unique_ptr< SidecarCache > cache;
+    bool useCache = true;
+    bool cachePending = false; ///< Cached segments wait for the end of the backfill
+    std::vector< LogBackfill::Column > cacheColumns; ///< Parsed by the tailer, not yet written, indexed by channel id
+    size_t cacheSamples = 0;
+    qint64 cacheBegin = 0; ///< Log offset where the unwritten part starts
+    QElapsedTimer cacheTimer;
+    ScopeDataParser parser;
+    ScopeDataParser::Line parsedLine;
+    unsigned knownChannels = 0; ///< Channel ids of the parser that are already listed
+};
@@ -0,0 +1,246 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <cstring>
+
+#include <QDateTime>
+#include <QDebug>
+#include <QFileInfo>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+#include "logtailer.h"
+#include "utils/frametrace.h"
+
+
+// Size of the file window that is mapped (or read) at once, a multi-GB log is scanned in several steps
+static const qint64 mapWindowSize = 64 << 20;
+static const qint64 readAheadSize = 4 << 20;
+// Poll interval if the platform does not notify about changes of files that are held open by the writer
+static const int fallbackInterval = 250;
+static const qint64 statisticsInterval = 1000;
+
+
+LogTailer::LogTailer( const QByteArray &key, QObject *parent )
+    : QObject( parent ), key( key ), file( this ), watcher( this ), fallbackTimer( this ) {
+    qRegisterMetaType< LogTailer::Statistics >();
+    connect( &watcher, &QFileSystemWatcher::fileChanged, this, &LogTailer::poll );
+    fallbackTimer.setInterval( fallbackInterval );
+    connect( &fallbackTimer, &QTimer::timeout, this, &LogTailer::poll );
+}
+
+
+LogTailer::~LogTailer() { close(); }
+
+
+bool LogTailer::open( const QString &fileName, qint64 startPosition ) {
+    const bool rotated = reopenPending && fileName == watchedFileName;
+    close();
+    file.setFileName( fileName );
+    if ( !file.open( QIODevice::ReadOnly ) ) // binary mode, lines end with "\n" or "\r\n"
+        return false;
+    watchedFileName = fileName;
+    filePosition = startPosition;
+    skippingLine = false;
+    openIdentity = fileIdentity( fileName );
+    watcher.addPath( fileName );
+    fallbackTimer.start();
+    statisticsTimer.start();
+    if ( rotated )
+        emit restarted( true );
+    return true;
+}
+
+
+void LogTailer::waitForReopen( const QString &fileName ) {
+    watchedFileName = fileName; // forgotten by close(), the path is polled without a watch
+    reopenPending = true;
+    fallbackTimer.start();
+}
+
+
+void LogTailer::close() {
+    reopenPending = false;
+    fallbackTimer.stop();
+    if ( !watchedFileName.isEmpty() )
+        watcher.removePath( watchedFileName );
+    watchedFileName.clear();
+    if ( file.isOpen() )
+        file.close();
+}
+
+
+int LogTailer::poll() {
+    if ( reopenPending ) { // the new file of a rotation was missing or not readable
+        const QString fileName = watchedFileName;
+        if ( !open( fileName ) ) {
+            waitForReopen( fileName );
+            return 0;
+        }
+    }
+    if ( !file.isOpen() )
+        return 0;
+    pollStart = FrameTrace::now();
+    int matches = 0;
+    const QByteArray identity = fileIdentity( watchedFileName );
+    if ( !identity.isEmpty() && identity != openIdentity ) { // rotated, a missing file may still be re-created
+        matches += scan(); // the rest of the old file, the writer has finished it
+        const QString fileName = watchedFileName;
+        reopenPending = true; // open() emits restarted()
+        if ( !open( fileName ) ) { // e.g. a permission race with the writer, retried by the next poll
+            waitForReopen( fileName );
+            if ( matches )
+                emit linesAvailable( matches );
+            return matches;
+        }
+    } else if ( file.size() < filePosition ) { // truncated in place
+        filePosition = 0;
+        skippingLine = false;
+        emit restarted( false );
+    }
+    matches += scan();
+    if ( matches )
+        emit linesAvailable( matches );
+    return matches;
+}
+
+
+int LogTailer::scan() {
+    if ( !file.isOpen() )
+        return 0;
+    QElapsedTimer scanTimer;
+    scanTimer.start();
+    const qint64 startPosition = filePosition;
+    const qint64 fileSize = file.size();
+    int matches = 0;
+    // the lines of the window, or only the end of a line that was too large for the window before
+    auto scanWindow = [ & ]( qint64 size ) -> qint64 {
+        if ( !skippingLine )
+            return scanLines( windowData, size, key, lineHandler, statisticsLines, matches );
+        const char *lineEnd = static_cast< const char * >( memchr( windowData, '\n', size_t( size ) ) );
+        if ( !lineEnd )
+            return size;
+        skippingLine = false;
+        ++statisticsLines;
+        return lineEnd + 1 - windowData;
+    };
+    while ( filePosition < fileSize ) {
+        qint64 block = qMin( fileSize - filePosition, mapWindowSize );
+        qint64 blockLimit = mapWindowSize;
+        qint64 consumed = 0;
+        uchar *mapped = file.map( filePosition, block );
+        windowOffset = filePosition;
+        if ( mapped ) {
+            windowData = reinterpret_cast< const char * >( mapped );
+            consumed = scanWindow( block );
+            file.unmap( mapped );
+        } else { // e.g. a pipe or a file system without mmap support
+            block = qMin( block, readAheadSize );
+            blockLimit = readAheadSize;
+            if ( readAhead.size() < block )
+                readAhead.resize( int( block ) );
+            if ( !file.seek( filePosition ) )
+                break;
+            block = file.read( readAhead.data(), block );
+            if ( block <= 0 )
+                break;
+            windowData = readAhead.constData();
+            consumed = scanWindow( block );
+        }
+        if ( 0 == consumed ) {
+            if ( block < blockLimit ) // incomplete last line, wait until the writer has finished it
+                break;
+            consumed = block; // a single line that is larger than the scan window, skip it up to its newline
+            skippingLine = true;
+        }
+        filePosition += consumed;
+    }
+    windowData = nullptr;
+    statisticsMatches += matches;
+    updateStatistics( filePosition - startPosition, scanTimer.nsecsElapsed() );
+    return matches;
+}
+
+
+// static
+qint64 LogTailer::scanLines( const char *data, qint64 size, const QByteArray &key, const LineHandler &handler, qint64 &lines,
+                             int &matches ) {
+    const char *const blockEnd = data + size;
+    const char *const keyData = key.constData();
+    const size_t keySize = size_t( key.size() );
+    const char *lineBegin = data;
+    while ( lineBegin < blockEnd ) {
+        const char *lineEnd = static_cast< const char * >( memchr( lineBegin, '\n', size_t( blockEnd - lineBegin ) ) );
+        if ( !lineEnd ) // keep the incomplete line for the next scan
+            break;
+        ++lines;
+        // the key is searched by its first char (memchr is vectorized) followed by a compare of the remainder
+        const char *candidate = lineBegin;
+        while ( keySize && candidate < lineEnd &&
+                ( candidate = static_cast< const char * >( memchr( candidate, keyData[ 0 ], size_t( lineEnd - candidate ) ) ) ) ) {
+            if ( size_t( lineEnd - candidate ) >= keySize && 0 == memcmp( candidate, keyData, keySize ) ) {
+                const char *contentEnd = lineEnd;
+                if ( contentEnd > candidate && contentEnd[ -1 ] == '\r' )
+                    --contentEnd;
+                ++matches;
+                if ( handler )
+                    handler( candidate + keySize, contentEnd );
+                break;
+            }
+            ++candidate;
+        }
+        lineBegin = lineEnd + 1;
+    }
+    return lineBegin - data;
+}
+
+
+// static
+const char *LogTailer::lineBegin( const char *data, const char *p ) {
+    while ( p > data && p[ -1 ] != '\n' )
+        --p;
+    return p;
+}
+
+
+// static
+QByteArray LogTailer::fileIdentity( const QString &fileName ) {
+#ifdef Q_OS_UNIX
+    struct stat status;
+    if ( stat( QFile::encodeName( fileName ).constData(), &status ) != 0 )
+        return QByteArray();
+    return QByteArray::number( qulonglong( status.st_dev ) ) + ':' + QByteArray::number( qulonglong( status.st_ino ) );
+#else
+    // no inode, a re-created file has a new creation time (if file system tunneling does not keep it,
+    // a smaller new file is still detected as a truncation)
+    const QFileInfo info( fileName );
+    if ( !info.exists() )
+        return QByteArray();
+    return QByteArray::number( info.created().toMSecsSinceEpoch() );
+#endif
+}
+
+
+void LogTailer::updateStatistics( qint64 bytes, qint64 nsecs ) {
+    statisticsBytes += bytes;
+    statisticsScanNsecs += nsecs;
+    const qint64 elapsed = statisticsTimer.elapsed();
+    if ( elapsed < statisticsInterval )
+        return;
+    if ( statisticsBytes ) { // report only while the log is growing
+        Statistics statistics;
+        const double seconds = elapsed / 1e3;
+        statistics.bytesPerSecond = statisticsBytes / seconds;
+        statistics.linesPerSecond = statisticsLines / seconds;
+        statistics.matchesPerSecond = statisticsMatches / seconds;
+        if ( statisticsScanNsecs )
+            statistics.scanBytesPerSecond = statisticsBytes * 1e9 / statisticsScanNsecs;
+        emit statisticsChanged( statistics );
+    }
+    statisticsBytes = 0;
+    statisticsLines = 0;
+    statisticsMatches = 0;
+    statisticsScanNsecs = 0;
+    statisticsTimer.restart();
+}
@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileSystemWatcher>
+#include <QObject>
+#include <QTimer>
+
+
+/// \brief Follows a growing text log and hands out the lines that carry a given key.
+///
+/// The tailer is woken by file change notifications (QFileSystemWatcher, i.e. inotify on Linux).
+/// New bytes are scanned directly in a memory mapped window of the file (or a large read-ahead
+/// buffer if mapping is not possible) for newline boundaries and the key. Only the byte ranges of
+/// matching lines are handed to the line handler, nothing is converted to QString on this path.
+/// Incomplete trailing lines are left in the file and picked up by the next scan.
+/// A log that is truncated or rotated (the path names another file, e.g. after a rename and re-create)
+/// is followed from its start again, the rest of a rotated file is scanned before it is closed. If the new file
+/// can not be opened yet, e.g. while the writer is still creating it, the tailer keeps polling its path.
+class LogTailer : public QObject {
+    Q_OBJECT
+
+  public:
+    /// \brief Called for every complete line that contains the key.
+    /// \param begin First byte after the key.
+    /// \param end One past the last byte of the line (newline excluded).
+    typedef std::function< void( const char *begin, const char *end ) > LineHandler;
+
+    /// \brief Throughput of the tailer, averaged over the last report interval.
+    struct Statistics {
+        double bytesPerSecond = 0.0;     ///< Bytes read from the log per wall clock second
+        double linesPerSecond = 0.0;     ///< Lines scanned per wall clock second
+        double matchesPerSecond = 0.0;   ///< Lines containing the key per wall clock second
+        double scanBytesPerSecond = 0.0; ///< Bytes per second spent scanning, i.e. the sustainable peak rate
+    };
+
+    explicit LogTailer( const QByteArray &key, QObject *parent = nullptr );
+    ~LogTailer() override;
+
+    /// \brief Open a log file and start watching it.
+    /// \param startPosition Scanning starts here, must be the beginning of a line.
+    /// \return true if the file could be opened. Emits restarted() if it replaces a rotated file that was waited for.
+    bool open( const QString &fileName, qint64 startPosition = 0 );
+    void close();
+    bool isOpen() const { return file.isOpen(); }
+    const QString &fileName() const { return watchedFileName; }
+
+    /// \brief Byte offset of the first byte that was not yet scanned.
+    qint64 position() const { return filePosition; }
+    /// \brief Time (FrameTrace::now()) at which the last poll() started to read, i.e. the lines it delivered
+    /// were in the file at this time.
+    int64_t pollTime() const { return pollStart; }
+    /// \brief Byte offset of `p`, only valid in the line handler.
+    qint64 offsetOf( const char *p ) const { return windowOffset + ( p - windowData ); }
+    /// \brief Byte offset of the start of the line that contains `p`, only valid in the line handler.
+    qint64 lineOffset( const char *p ) const { return windowOffset + ( lineBegin( windowData, p ) - windowData ); }
+
+    void setLineHandler( LineHandler handler ) { lineHandler = std::move( handler ); }
+
+    /// \brief Hand every complete line of `data` that contains `key` to `handler`.
+    /// \param lines Incremented by the number of complete lines.
+    /// \param matches Incremented by the number of lines that contain the key.
+    /// \return The number of bytes consumed, i.e. up to and including the last newline.
+    static qint64 scanLines( const char *data, qint64 size, const QByteArray &key, const LineHandler &handler, qint64 &lines,
+                             int &matches );
+    /// \brief Return the start of the line that contains `p`, searching back not further than `data`.
+    static const char *lineBegin( const char *data, const char *p );
+
+  public slots:
+    /// \brief Scan all bytes appended since the last call.
+    /// \return The number of lines that matched the key.
+    int poll();
+
+  signals:
+    /// A poll delivered `matches` lines to the line handler.
+    void linesAvailable( int matches );
+    /// Emitted about once per second while the log is growing.
+    void statisticsChanged( const LogTailer::Statistics &statistics );
+    /// The file was truncated or replaced by a new one, the tailer continues at its start.
+    /// Emitted before the first line of the new content is handed out.
+    void restarted( bool rotated );
+
+  private:
+    /// \brief Scan the bytes of the open file from filePosition up to its end.
+    int scan();
+    /// \brief Identity of the file at `fileName` (device and inode where available), empty if there is none.
+    static QByteArray fileIdentity( const QString &fileName );
+    void updateStatistics( qint64 bytes, qint64 nsecs );
+    /// \brief The new file of a rotation could not be opened, keep polling `fileName` until it can.
+    void waitForReopen( const QString &fileName );
+
+    QByteArray key;
+    LineHandler lineHandler;
+    QFile file;
+    QString watchedFileName;
+    QFileSystemWatcher watcher;
+    QTimer fallbackTimer;   ///< Some platforms do not report appends to a file that is held open by the writer
+    QByteArray readAhead;   ///< Used if the file can not be mapped
+    qint64 filePosition = 0;
+    int64_t pollStart = 0;
+    QByteArray openIdentity; ///< fileIdentity() of the open file
+    bool reopenPending = false; ///< Rotated, the new file is not open yet, poll() retries
+    bool skippingLine = false;  ///< Inside a line larger than the scan window, scan() resumes after its newline
+    const char *windowData = nullptr; ///< The window that is scanned right now, see lineOffset()
+    qint64 windowOffset = 0;
+
+    QElapsedTimer statisticsTimer;
+    qint64 statisticsBytes = 0;
+    qint64 statisticsLines = 0;
+    qint64 statisticsMatches = 0;
+    qint64 statisticsScanNsecs = 0;
+};
+
+Q_DECLARE_METATYPE( LogTailer::Statistics )
@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <algorithm>
+#include <iterator>
+
+#include "logtimeindex.h"
+
+
+void LogTimeIndex::add( qint64 offset, int64_t time ) {
+    if ( !wants( offset ) )
+        return;
+    if ( !entries.empty() )
+        time = std::max( time, entries.back().time );
+    entries.push_back( { offset, time } );
+}
+
+
+void LogTimeIndex::insert( const std::vector< Entry > &older ) {
+    if ( older.empty() )
+        return;
+    std::vector< Entry > merged;
+    merged.reserve( entries.size() + older.size() );
+    std::merge( entries.begin(), entries.end(), older.begin(), older.end(), std::back_inserter( merged ),
+                []( const Entry &a, const Entry &b ) { return a.offset < b.offset; } );
+    entries.clear();
+    for ( const Entry &entry : merged ) { // thin out to the stride, keep the times sorted for the search
+        if ( !entries.empty() && entry.offset < entries.back().offset + stride )
+            continue;
+        entries.push_back( { entry.offset, entries.empty() ? entry.time : std::max( entry.time, entries.back().time ) } );
+    }
+}
+
+
+qint64 LogTimeIndex::offsetAt( int64_t time ) const {
+    const auto after = std::upper_bound( entries.begin(), entries.end(), time,
+                                         []( int64_t t, const Entry &entry ) { return t < entry.time; } );
+    return after == entries.begin() ? 0 : ( after - 1 )->offset;
+}
@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <QtGlobal>
+
+
+/// \brief Sparse map from byte offsets of a log to the time stamps of the lines there.
+///
+/// About one entry per `stride` bytes is kept, each one points to the start of a line, so a multi-GB
+/// log needs a few thousand entries only. The time stamps are kept non-decreasing (a time that goes
+/// backwards is clamped like SampleData::addData() does it), a time is found by a binary search.
+/// Not thread safe, the owner guards it.
+class LogTimeIndex {
+  public:
+    struct Entry {
+        qint64 offset; ///< Start of a line
+        int64_t time;  ///< Time stamp (ns) of that line
+    };
+
+    static const qint64 stride = 1 << 20;
+
+    /// \brief Whether a line at `offset` after the newest entry is far enough from it to be indexed.
+    bool wants( qint64 offset ) const { return entries.empty() || offset >= entries.back().offset + stride; }
+    /// \brief Append an entry after the newest one, ignored if it is too close to it.
+    void add( qint64 offset, int64_t time );
+    /// \brief Merge the entries of an older part of the log, e.g. of a backfill chunk or a cached segment.
+    void insert( const std::vector< Entry > &older );
+    void clear() { entries.clear(); }
+    size_t size() const { return entries.size(); }
+
+    /// \brief Offset of the last indexed line at or before `time`, scanning from there reaches `time`.
+    /// \return 0 if `time` is before the first entry.
+    qint64 offsetAt( int64_t time ) const;
+
+  private:
+    std::vector< Entry > entries; ///< Ascending offsets and times
+};
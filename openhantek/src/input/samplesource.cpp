@@ -0,0 +1,151 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <algorithm>
+
+#include <QDebug>
+#include <QMutexLocker>
+
+#include "samplesource.h"
+
+
+SampleSource::SampleSource( const QString &prefix, int verboseLevel )
+    : verboseLevel( verboseLevel ), namePrefix( prefix ), parseStage( FrameTrace::instance().stage( "parse" ) ) {}
+
+
+SampleSource::~SampleSource() {
+    qDeleteAll( channels ); // the rings return their blocks to blockPool
+}
+
+
+bool SampleSource::snapshot( const QString &name, int64_t duration, SampleSnapshot &snapshot, int64_t &end,
+                             FrameStamps *stamps ) const {
+    QMutexLocker locker( &mutex );
+    const SampleData *sampleData = byName.value( name, nullptr );
+    if ( !sampleData || sampleData->data.empty() ) {
+        snapshot.clear();
+        return false;
+    }
+    end = latestTime;
+    sampleData->data.snapshot( end - duration, snapshot );
+    if ( stamps ) {
+        stamps->read = std::max( stamps->read, published.read );
+        stamps->parsed = std::max( stamps->parsed, published.parsed );
+    }
+    return true;
+}
+
+
+QStringList SampleSource::channelNames() const {
+    QMutexLocker locker( &mutex );
+    QStringList names;
+    for ( const SampleData *sampleData : channels )
+        if ( sampleData )
+            names << sampleData->name;
+    return names;
+}
+
+
+void SampleSource::setRetention( size_t blocks, int64_t duration ) {
+    QMutexLocker locker( &mutex );
+    maxBlocks = blocks;
+    retentionTime = duration;
+    for ( SampleData *sampleData : channels ) {
+        if ( sampleData ) {
+            sampleData->data.setMaxBlocks( maxBlocks );
+            sampleData->data.setRetentionTime( retentionTime );
+        }
+    }
+}
+
+
+size_t SampleSource::channelCount() const {
+    QMutexLocker locker( &mutex );
+    return size_t( byName.size() );
+}
+
+
+size_t SampleSource::storingChannelCount( const ChannelFilter &filter ) const {
+    QMutexLocker locker( &mutex );
+    const std::string qualifiedPrefix = namePrefix.toStdString() + ':';
+    size_t count = 0;
+    for ( const SampleData *sampleData : channels )
+        if ( sampleData && ( !sampleData->data.empty() || filter.matches( qualifiedPrefix + sampleData->name.toStdString() ) ) )
+            ++count;
+    return count;
+}
+
+
+void SampleSource::setSubscription( const QStringList &patterns ) {
+    std::vector< std::string > list;
+    for ( const QString &pattern : patterns )
+        list.push_back( pattern.toStdString() );
+    QStringList newlySubscribed;
+    {
+        QMutexLocker locker( &mutex );
+        filter = ChannelFilter( std::move( list ) );
+        for ( SampleData *sampleData : channels ) {
+            if ( !sampleData )
+                continue;
+            const bool subscribed = isSubscribed( sampleData->name.toStdString() );
+            if ( subscribed && !sampleData->subscribed )
+                newlySubscribed << sampleData->name;
+            sampleData->subscribed = subscribed;
+        }
+    }
+    if ( verboseLevel > 2 )
+        qDebug() << "  SampleSource::setSubscription()" << namePrefix << patterns << "new:" << newlySubscribed;
+    subscriptionChanged( newlySubscribed );
+}
+
+
+bool SampleSource::isSubscribed( const std::string &name ) const {
+    return filter.matches( namePrefix.toStdString() + ':' + name );
+}
+
+
+std::function< bool( const char *, size_t ) > SampleSource::subscription() const {
+    const ChannelFilter copy = filter;
+    const std::string qualifiedPrefix = namePrefix.toStdString() + ':';
+    return [ copy, qualifiedPrefix ]( const char *name, size_t length ) {
+        return copy.matches( qualifiedPrefix + std::string( name, length ) );
+    };
+}
+
+
+SampleData *SampleSource::addChannel( unsigned id, const QString &name ) {
+    if ( id >= channels.size() )
+        channels.resize( id + 1, nullptr );
+    SampleData *&sampleData = channels[ id ];
+    if ( !sampleData ) {
+        sampleData = new SampleData( &blockPool );
+        sampleData->name = name;
+        sampleData->subscribed = isSubscribed( name.toStdString() );
+        sampleData->data.setMaxBlocks( maxBlocks );
+        sampleData->data.setRetentionTime( retentionTime );
+        byName.insert( name, sampleData );
+        newNames << name;
+        if ( verboseLevel > 2 )
+            qDebug() << "  SampleSource::addChannel()" << namePrefix << name << id;
+    }
+    return sampleData;
+}
+
+
+void SampleSource::publish( int64_t readTime ) {
+    QStringList names;
+    const int64_t parsedTime = FrameTrace::now();
+    if ( readTime )
+        FrameTrace::instance().span( parseStage, readTime, parsedTime );
+    {
+        QMutexLocker locker( &mutex );
+        published.read = readTime ? readTime : parsedTime;
+        published.parsed = parsedTime;
+        for ( const SampleData *sampleData : channels )
+            if ( sampleData && !sampleData->data.empty() )
+                latestTime = std::max( latestTime, sampleData->data.backTime() );
+        names.swap( newNames );
+    }
+    if ( !names.isEmpty() )
+        emit channelsAdded( names );
+    emit samplesAdded();
+}
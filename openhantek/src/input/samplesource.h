@@ -0,0 +1,125 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "channelfilter.h"
+#include "samplestore.h"
+#include "utils/frametrace.h"
+
+
+/// \brief Samples of one named input channel.
+struct SampleData {
+  public:
+    explicit SampleData( SampleBlockPool *pool ) : data( pool ) {}
+
+    QString name = "";
+    SampleRing data;        ///< Bounded by the retention settings, old samples are evicted
+    bool subscribed = true; ///< Values of other channels are skipped, the channel is only listed
+
+    /// \brief Append `value` at `time` (ns), a time that goes backwards (e.g. a restarted producer)
+    /// is clamped to the newest one, the ring stays sorted for the snapshots and the resampling.
+    void addData( int64_t time, double value ) {
+        if ( !data.empty() && time < data.backTime() )
+            time = data.backTime();
+        data.append( time, value );
+    }
+};
+
+
+/// \brief Base class of all inputs that produce named sample channels, e.g. a followed log file.
+///
+/// A source runs in its own thread and owns its channels, its block pool and its parser state.
+/// The channels are appended to by the source thread only. Other threads access them through the
+/// thread safe snapshot() and channelNames(), a per source mutex keeps the sources independent of each other.
+class SampleSource : public QObject {
+    Q_OBJECT
+
+  public:
+    /// \param prefix Prepended to the channel names of this source by the SourceManager, e.g. "server".
+    explicit SampleSource( const QString &prefix, int verboseLevel = 0 );
+    ~SampleSource() override;
+
+    const QString &prefix() const { return namePrefix; }
+    /// \brief Change the prefix, only before the source is started.
+    void setPrefix( const QString &prefix ) { namePrefix = prefix; }
+
+    /// \brief Thread safe, fill `snapshot` with the samples of channel `name` of the last `duration` ns.
+    /// The span ends at the newest published sample of this source, all channels of a source share one clock.
+    /// \param end Set to the time (ns) of the newest published sample of this source.
+    /// \param stamps If set, its read and parsed times are raised to those of the last publish().
+    /// \return false if this source has no such channel.
+    bool snapshot( const QString &name, int64_t duration, SampleSnapshot &snapshot, int64_t &end,
+                   FrameStamps *stamps = nullptr ) const;
+    /// \brief Thread safe, the names of all channels seen so far (without prefix).
+    QStringList channelNames() const;
+    /// \brief Thread safe, limit every channel ring to `maxBlocks` blocks and `retentionTime` ns (0: no limit).
+    void setRetention( size_t maxBlocks, int64_t retentionTime );
+    size_t channelCount() const;
+    /// \brief Thread safe, the channels that hold samples or whose qualified names match `filter`.
+    /// Only these share the memory budget, the other channels are merely listed.
+    size_t storingChannelCount( const ChannelFilter &filter ) const;
+
+  public slots:
+    /// \brief Subscribe the channels whose qualified names match one of the wildcard `patterns`, see ChannelFilter.
+    /// Called directly before the source is started, queued in the thread of the source afterwards.
+    void setSubscription( const QStringList &patterns );
+    /// \brief Called in the thread of the source once the thread has started.
+    virtual void start() = 0;
+    /// \brief Called in the thread of the source before the thread quits.
+    virtual void stop() = 0;
+    /// \brief Look for new data now, e.g. on user request.
+    virtual void refresh() {}
+
+  signals:
+    void samplesAdded();                            ///< New samples were appended to the channels
+    void channelsAdded( const QStringList &names ); ///< New channels were discovered
+    void statusMessage( const QString &message, int timeout );
+
+  protected:
+    /// \brief Return the channel `id` of this source or nullptr if it was not yet added.
+    SampleData *channel( unsigned id ) const { return id < channels.size() ? channels[ id ] : nullptr; }
+    /// \brief Create the channel `id` as `name`.
+    /// Must be called from the source thread with `mutex` held.
+    SampleData *addChannel( unsigned id, const QString &name );
+    /// \brief Announce the new samples and channels.
+    /// Must be called from the source thread without `mutex` held.
+    /// \param readTime FrameTrace::now() when the newest published bytes were read, 0 if they were not read just now.
+    void publish( int64_t readTime = 0 );
+    /// \brief Whether the qualified name of channel `name` matches the subscription.
+    bool isSubscribed( const std::string &name ) const;
+    /// \brief A copy of the subscription for other threads or parsers, matches unqualified names.
+    std::function< bool( const char *name, size_t length ) > subscription() const;
+    /// \brief The retention time (ns, 0: no limit), called with `mutex` held.
+    int64_t retention() const { return retentionTime; }
+    /// \brief Time (ns) of the newest published sample, called with `mutex` held.
+    int64_t newestTime() const { return latestTime; }
+    /// \brief Called in the source thread after setSubscription() with the channels that are subscribed now
+    /// but were not before.
+    virtual void subscriptionChanged( const QStringList &newlySubscribed ) { Q_UNUSED( newlySubscribed ) }
+
+    mutable QMutex mutex; ///< Guards the channels against concurrent snapshots
+    int verboseLevel = 0;
+
+  private:
+    QString namePrefix;
+    ChannelFilter filter;
+    SampleBlockPool blockPool;            ///< Used by the source thread only
+    std::vector< SampleData * > channels; ///< Indexed by the channel id of the source
+    QHash< QString, SampleData * > byName;
+    QStringList newNames; ///< Discovered since the last publish()
+    size_t maxBlocks = 2;
+    int64_t retentionTime = 0;
+    int64_t latestTime = std::numeric_limits< int64_t >::min(); ///< Newest published sample of all channels
+    FrameStamps published;                                      ///< read and parsed time of the last publish()
+    unsigned parseStage;                                        ///< FrameTrace stage of the parsing
+};
@@ -0,0 +1,349 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <algorithm>
+#include <cmath>
+
+#include "samplestore.h"
+
+
+void SampleBlock::summarize( size_t begin, size_t end ) {
+    for ( unsigned level = 1; level <= levels; ++level ) {
+        const unsigned bits = fanOutBits * level;
+        const size_t size = size_t( 1 ) << bits;
+        // the nodes that contain a sample of [begin, end), without the ones that reach beyond [start, count)
+        size_t first = begin >> bits;
+        const size_t last = ( end - 1 ) >> bits;
+        if ( first << bits < start )
+            ++first;
+        StoredSample *nodeMinima = minima + levelOffset( level );
+        StoredSample *nodeMaxima = maxima + levelOffset( level );
+        for ( size_t node = first; node <= last && ( node + 1 ) * size <= count; ++node ) {
+            // the children are the values on level 1, else the nodes of the level below
+            const size_t child = node << fanOutBits;
+            const StoredSample *childMinima = 1 == level ? values + child : minima + levelOffset( level - 1 ) + child;
+            const StoredSample *childMaxima = 1 == level ? values + child : maxima + levelOffset( level - 1 ) + child;
+            StoredSample low = childMinima[ 0 ];
+            StoredSample high = childMaxima[ 0 ];
+            for ( size_t i = 1; i < fanOut; ++i ) {
+                low = std::min( low, childMinima[ i ] );
+                high = std::max( high, childMaxima[ i ] );
+            }
+            nodeMinima[ node ] = low;
+            nodeMaxima[ node ] = high;
+        }
+    }
+}
+
+
+void SampleBlock::extent( size_t begin, size_t end, double &minimum, double &maximum ) const {
+    StoredSample low = values[ begin ];
+    StoredSample high = values[ begin ];
+    const auto take = [ & ]( unsigned level, size_t index ) {
+        if ( level ) {
+            low = std::min( low, minima[ levelOffset( level ) + index ] );
+            high = std::max( high, maxima[ levelOffset( level ) + index ] );
+        } else {
+            low = std::min( low, values[ index ] );
+            high = std::max( high, values[ index ] );
+        }
+    };
+    // [begin, end) in units of the nodes of `level`, the aligned middle is handed to the next level
+    for ( unsigned level = 0; begin < end; ++level ) {
+        if ( level == levels ) { // the whole block
+            take( level, begin );
+            break;
+        }
+        const size_t alignedBegin = std::min( ( begin + fanOut - 1 ) & ~( fanOut - 1 ), end );
+        for ( ; begin < alignedBegin; ++begin )
+            take( level, begin );
+        const size_t alignedEnd = std::max( end & ~( fanOut - 1 ), begin );
+        while ( end > alignedEnd )
+            take( level, --end );
+        begin >>= fanOutBits;
+        end >>= fanOutBits;
+    }
+    // the decoding keeps the order, the scale is positive
+    minimum = std::min( minimum, StoredSampleCodec::decode( low, scale ) );
+    maximum = std::max( maximum, StoredSampleCodec::decode( high, scale ) );
+}
+
+
+SampleBlockPool::SampleBlockPool() : live( std::make_shared< std::atomic< size_t > >( 0 ) ) {}
+
+
+SampleBlockPool::~SampleBlockPool() = default;
+
+
+SampleBlockPtr SampleBlockPool::acquire() {
+    if ( !pool.empty() ) {
+        SampleBlockPtr block = std::move( pool.back() );
+        pool.pop_back();
+        block->start = 0;
+        block->count = 0;
+        block->scale = 1.0;
+        return block;
+    }
+    std::shared_ptr< std::atomic< size_t > > counter = live;
+    ++*counter;
+    return SampleBlockPtr( new SampleBlock, [ counter ]( SampleBlock *block ) {
+        --*counter;
+        delete block;
+    } );
+}
+
+
+void SampleBlockPool::recycle( SampleBlockPtr &&block ) {
+    if ( block.use_count() == 1 ) // not referenced by a snapshot
+        pool.push_back( std::move( block ) );
+    else
+        block.reset(); // the last snapshot frees it
+}
+
+
+void SampleSnapshot::copyTo( std::vector< Sample > &destination ) const {
+    destination.resize( count );
+    size_t index = first;
+    size_t done = 0;
+    for ( const auto &block : blocks ) {
+        // all but the first and the last block are full, the count of the newest block may grow meanwhile
+        const size_t n = std::min( SampleBlock::capacity - index, count - done );
+        Sample *out = destination.data() + done;
+        for ( size_t i = 0; i < n; ++i )
+            out[ i ] = Sample( block->value( index + i ) );
+        done += n;
+        index = 0;
+        if ( done == count )
+            break;
+    }
+}
+
+
+void SampleSnapshot::resample( int64_t start, double interval, size_t points, std::vector< Sample > &destination ) const {
+    destination.resize( points );
+    if ( !points )
+        return;
+    Sample *out = destination.data();
+    if ( empty() ) {
+        std::fill( out, out + points, Sample( 0 ) );
+        return;
+    }
+    // Sample i holds its value from grid point ceil( ( time( i ) - start ) / interval ) up to the one of sample i + 1.
+    // The grid positions of a chunk of time stamps are computed in a branch free loop first, then every
+    // held value is written with one fill, so the inner loops run over contiguous columns only.
+    const size_t chunk = 256;
+    double positions[ chunk ];
+    const double toGrid = 1.0 / interval;
+    const double lastPoint = double( points );
+    Sample value = Sample( ( *this )[ 0 ] );
+    size_t done = 0; // grid points written so far
+    size_t index = first;
+    size_t remaining = count;
+    for ( const auto &block : blocks ) {
+        const size_t n = std::min( SampleBlock::capacity - index, remaining );
+        for ( size_t offset = 0; offset < n && done < points; offset += chunk ) {
+            const size_t m = std::min( chunk, n - offset );
+            const int64_t *times = block->times + index + offset;
+            const StoredSample *values = block->values + index + offset;
+            for ( size_t i = 0; i < m; ++i )
+                positions[ i ] = std::min( std::max( std::ceil( double( times[ i ] - start ) * toGrid ), 0.0 ), lastPoint );
+            for ( size_t i = 0; i < m; ++i ) {
+                const size_t end = size_t( positions[ i ] );
+                if ( end > done ) {
+                    std::fill( out + done, out + end, value );
+                    done = end;
+                }
+                value = Sample( StoredSampleCodec::decode( values[ i ], block->scale ) );
+            }
+        }
+        remaining -= n;
+        index = 0;
+        if ( !remaining )
+            break;
+    }
+    std::fill( out + done, out + points, value );
+}
+
+
+void SampleSnapshot::envelope( int64_t start, double interval, size_t points, std::vector< Sample > &minima,
+                               std::vector< Sample > &maxima ) const {
+    minima.resize( points );
+    maxima.resize( points );
+    if ( empty() ) {
+        std::fill( minima.begin(), minima.end(), Sample( 0 ) );
+        std::fill( maxima.begin(), maxima.end(), Sample( 0 ) );
+        return;
+    }
+    size_t next = after( start, 0.0, 0 ); // the first sample after the begin of the interval
+    for ( size_t point = 0; point < points; ++point ) {
+        // from the held value (or the first one) up to the one that is held at the begin of the next interval
+        const size_t begin = next ? next - 1 : 0;
+        next = after( start, double( point + 1 ) * interval, next );
+        const size_t end = std::max( next ? next - 1 : 0, begin + 1 );
+        double minimum = ( *this )[ begin ];
+        double maximum = minimum;
+        size_t index = begin + first;
+        const size_t last = end + first;
+        while ( index < last ) {
+            const size_t offset = index % SampleBlock::capacity;
+            const size_t n = std::min( SampleBlock::capacity - offset, last - index );
+            blocks[ index / SampleBlock::capacity ]->extent( offset, offset + n, minimum, maximum );
+            index += n;
+        }
+        minima[ point ] = Sample( minimum );
+        maxima[ point ] = Sample( maximum );
+    }
+}
+
+
+size_t SampleSnapshot::after( int64_t start, double offset, size_t from ) const {
+    // binary search, the time stamps never decrease
+    size_t low = from;
+    size_t high = count;
+    while ( low < high ) {
+        const size_t middle = low + ( high - low ) / 2;
+        if ( double( time( middle ) - start ) <= offset )
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+
+void SampleSnapshot::clear() {
+    blocks.clear();
+    first = 0;
+    count = 0;
+}
+
+
+SampleRing::SampleRing( SampleBlockPool *pool, size_t maxBlocks ) : pool( pool ), ring( std::max( maxBlocks, size_t( 2 ) ) ) {}
+
+
+SampleRing::~SampleRing() {
+    while ( used )
+        evictOldest();
+}
+
+
+void SampleRing::clear() {
+    while ( used )
+        evictOldest();
+}
+
+
+void SampleRing::setMaxBlocks( size_t maxBlocks ) {
+    maxBlocks = std::max( maxBlocks, size_t( 2 ) ); // the newest block may be almost empty
+    if ( maxBlocks == ring.size() )
+        return;
+    while ( used > maxBlocks )
+        evictOldest();
+    std::vector< SampleBlockPtr > resized( maxBlocks );
+    for ( size_t age = 0; age < used; ++age )
+        resized[ age ] = std::move( ring[ ( head + age ) % ring.size() ] );
+    ring.swap( resized );
+    head = 0;
+}
+
+
+size_t SampleRing::prepend( const int64_t *times, const double *values, size_t count ) {
+    if ( !count )
+        return 0;
+    const int64_t newest = retained ? backTime() : times[ count - 1 ];
+    const int64_t limit = retained ? block( 0 )->times[ block( 0 )->start ] : newest;
+    size_t begin = 0;
+    if ( retentionTime ) // skip the samples that are already out of the retention time
+        begin = size_t( std::lower_bound( times, times + count, newest - retentionTime ) - times );
+    // fill the oldest block downwards, then start new blocks in front of it that are filled from their end
+    size_t end = count;
+    while ( end > begin ) {
+        SampleBlock *front = used ? block( 0 ).get() : nullptr;
+        if ( !front || 0 == front->start ) {
+            if ( used == ring.size() )
+                break;
+            head = ( head + ring.size() - 1 ) % ring.size();
+            ring[ head ] = pool->acquire();
+            front = ring[ head ].get();
+            front->start = front->count = SampleBlock::capacity;
+            if ( StoredSampleCodec::isQuantized ) { // the whole history of the block is known, it sets the scale
+                double historyPeak = 0.0;
+                for ( size_t i = end - std::min( size_t( SampleBlock::capacity ), end - begin ); i < end; ++i )
+                    historyPeak = std::max( historyPeak, std::fabs( values[ i ] ) );
+                front->scale = StoredSampleCodec::scaleFor( historyPeak );
+            }
+            if ( !used++ )
+                tail = front;
+        }
+        const size_t n = std::min( front->start, end - begin );
+        for ( size_t i = 1; i <= n; ++i ) {
+            front->times[ front->start - i ] = std::min( times[ end - i ], limit );
+            front->values[ front->start - i ] = StoredSampleCodec::encode( values[ end - i ], front->scale );
+        }
+        front->start -= n;
+        front->summarize( front->start, front->start + n );
+        end -= n;
+    }
+    const size_t stored = count - end;
+    retained += stored;
+    appendedCount += stored;
+    return stored;
+}
+
+
+void SampleRing::snapshot( int64_t from, SampleSnapshot &snapshot ) const {
+    snapshot.clear();
+    if ( !retained )
+        return;
+    // walk back from the newest block to the one that holds the value at `from`
+    size_t firstBlock = used;
+    size_t covered = 0;
+    const SampleBlock *current = nullptr;
+    size_t offset = 0;
+    while ( firstBlock > 0 ) {
+        current = block( --firstBlock ).get();
+        covered += current->count - current->start;
+        offset = current->start;
+        if ( current->times[ current->start ] <= from ) {
+            const int64_t *end = current->times + current->count;
+            offset = size_t( std::upper_bound( current->times + current->start, end, from ) - current->times ) - 1;
+            break;
+        }
+    }
+    for ( size_t age = firstBlock; age < used; ++age )
+        snapshot.blocks.push_back( block( age ) );
+    snapshot.first = offset;
+    snapshot.count = covered - ( offset - current->start );
+}
+
+
+void SampleRing::nextBlock( int64_t time, double value ) {
+    if ( retentionTime ) {
+        while ( used ) {
+            const SampleBlock *oldest = block( 0 ).get();
+            if ( time - oldest->times[ oldest->count - 1 ] <= retentionTime )
+                break;
+            evictOldest();
+        }
+    }
+    if ( used == ring.size() )
+        evictOldest();
+    SampleBlockPtr &slot = ring[ ( head + used ) % ring.size() ];
+    slot = pool->acquire();
+    tail = slot.get();
+    if ( StoredSampleCodec::isQuantized ) {
+        tail->scale = StoredSampleCodec::scaleFor( std::max( peak, std::fabs( value ) ) );
+        peak = 0.0;
+    }
+    ++used;
+}
+
+
+void SampleRing::evictOldest() {
+    SampleBlockPtr &oldest = ring[ head ];
+    retained -= oldest->count - oldest->start;
+    if ( oldest.get() == tail )
+        tail = nullptr;
+    pool->recycle( std::move( oldest ) );
+    head = ( head + 1 ) % ring.size();
+    --used;
+}
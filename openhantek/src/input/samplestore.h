@@ -0,0 +1,187 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "sampletype.h"
+
+
+/// \brief Fixed size block of samples, the unit of allocation, retention and recycling of the sample store.
+/// Time stamps (ns) and values are stored in separate columns, the time stamps never decrease.
+/// The values are stored as StoredSample, quantized types use the `scale` of their block (see SampleCodec).
+/// Each block keeps a min/max pyramid of its values with a fan-out of 8, level l >= 1 has one node per
+/// 8^l samples. A node is written once, when its last sample becomes valid, so the range queries of
+/// a snapshot never see a node change.
+/// A block is only written by the thread that owns its SampleRing and only at positions >= count
+/// or < start, the samples in between never change while the block is referenced by a SampleSnapshot.
+struct SampleBlock {
+    static const size_t capacity = 4096;
+    static const unsigned fanOutBits = 3; ///< 8 children per node of the pyramid
+    static const size_t fanOut = size_t( 1 ) << fanOutBits;
+    static const unsigned levels = 4;             ///< Nodes of 8, 64, 512 and 4096 samples
+    static const size_t nodes = 512 + 64 + 8 + 1; ///< Nodes of all levels
+    size_t start = 0; ///< First valid sample, > 0 only for the oldest block of prepended history
+    size_t count = 0; ///< One past the last valid sample
+    double scale = 1.0; ///< Step of a quantized value, fixed while the block is in use
+    int64_t times[ capacity ];
+    StoredSample values[ capacity ];
+    StoredSample minima[ nodes ]; ///< The pyramid, level by level, only nodes within [start, count) are valid
+    StoredSample maxima[ nodes ];
+
+    double value( size_t index ) const { return StoredSampleCodec::decode( values[ index ], scale ); }
+    /// \brief Position of node 0 of `level` (1 ... levels) in minima and maxima.
+    static constexpr size_t levelOffset( unsigned level ) {
+        return level <= 1 ? 0 : levelOffset( level - 1 ) + ( capacity >> ( fanOutBits * ( level - 1 ) ) );
+    }
+    /// \brief Compute the nodes of all levels that cover one of the samples [begin, end) and lie within [start, count).
+    void summarize( size_t begin, size_t end );
+    /// \brief Smallest and largest value of the samples [begin, end) within [start, count), begin < end.
+    /// Walks up the pyramid, the unaligned ends are read on the finest levels, the middle on the coarsest one.
+    /// Costs O( levels * fanOut ) instead of O( end - begin ).
+    void extent( size_t begin, size_t end, double &minimum, double &maximum ) const;
+};
+
+typedef std::shared_ptr< SampleBlock > SampleBlockPtr;
+
+
+/// \brief Hands out sample blocks and takes back the blocks evicted by the rings.
+/// A returned block that is still referenced by a snapshot is not reused, it is freed by the
+/// last reader instead. The pool is used by one thread only, the live block count is thread safe.
+class SampleBlockPool {
+  public:
+    SampleBlockPool();
+    ~SampleBlockPool();
+    SampleBlockPool( const SampleBlockPool & ) = delete;
+
+    SampleBlockPtr acquire();
+    void recycle( SampleBlockPtr &&block );
+
+    /// \brief Number of blocks in memory, i.e. in use by rings, held by snapshots or kept for reuse.
+    size_t liveBlocks() const { return *live; }
+    size_t freeBlocks() const { return pool.size(); }
+    static size_t blockBytes() { return sizeof( SampleBlock ); }
+
+  private:
+    std::vector< SampleBlockPtr > pool;
+    std::shared_ptr< std::atomic< size_t > > live; ///< Shared with the deleter of blocks that outlive the pool
+};
+
+
+/// \brief Stable read only view of the newest samples of a SampleRing.
+/// The view keeps its blocks alive, later appends or evictions of the ring never invalidate it.
+class SampleSnapshot {
+  public:
+    size_t size() const { return count; }
+    bool empty() const { return 0 == count; }
+    double operator[]( size_t index ) const {
+        index += first;
+        return blocks[ index / SampleBlock::capacity ]->value( index % SampleBlock::capacity );
+    }
+    /// \brief Time stamp (ns) of sample `index`.
+    int64_t time( size_t index ) const {
+        index += first;
+        return blocks[ index / SampleBlock::capacity ]->times[ index % SampleBlock::capacity ];
+    }
+    double back() const { return ( *this )[ count - 1 ]; }
+    int64_t backTime() const { return time( count - 1 ); }
+
+    /// \brief Copy all values into a contiguous vector, the capacity of the destination is reused.
+    void copyTo( std::vector< Sample > &destination ) const;
+    /// \brief Sample the values on the uniform grid `start` + i * `interval` (ns), i < `points`.
+    /// A grid point gets the value of the newest sample at or before it (sample and hold), points before
+    /// the first sample get the first value. Costs O(size() + points), the capacity of the destination is reused.
+    void resample( int64_t start, double interval, size_t points, std::vector< Sample > &destination ) const;
+    /// \brief Smallest and largest value per interval [ `start` + i * `interval`, `start` + ( i + 1 ) * `interval` )
+    /// (ns), i < `points`: from the value that resample() holds at its begin up to the sample before the one held
+    /// at the begin of the next interval, so no sample is lost, however narrow. The ranges are read from the
+    /// pyramids of the blocks on the level that matches the samples per interval, O( points * log( size() ) ).
+    void envelope( int64_t start, double interval, size_t points, std::vector< Sample > &minima,
+                   std::vector< Sample > &maxima ) const;
+    void clear();
+    /// \brief First index of a sample after `time` (ns), size() if there is none.
+    size_t after( int64_t time ) const { return after( time, 0.0, 0 ); }
+
+  private:
+    friend class SampleRing;
+    /// \brief First index >= `from` of a sample after `start` + `offset` (ns), size() if there is none.
+    size_t after( int64_t start, double offset, size_t from ) const;
+    std::vector< std::shared_ptr< const SampleBlock > > blocks;
+    size_t first = 0; ///< Index of the first sample in blocks.front()
+    size_t count = 0;
+};
+
+
+/// \brief Bounded channel storage, a ring of fixed size blocks.
+/// Appending to a full ring evicts the oldest block, the memory of a ring never exceeds
+/// maxBlocks() * SampleBlockPool::blockBytes() regardless of the session length.
+class SampleRing {
+  public:
+    explicit SampleRing( SampleBlockPool *pool, size_t maxBlocks = 2 );
+    ~SampleRing();
+    SampleRing( const SampleRing & ) = delete;
+
+    /// \brief Append `value` at `time` (ns), `time` must not be older than backTime().
+    void append( int64_t time, double value ) {
+        if ( !tail || tail->count == SampleBlock::capacity )
+            nextBlock( time, value );
+        if ( StoredSampleCodec::isQuantized )
+            peak = std::max( peak, std::fabs( value ) );
+        tail->times[ tail->count ] = time;
+        tail->values[ tail->count++ ] = StoredSampleCodec::encode( value, tail->scale );
+        if ( !( tail->count & ( SampleBlock::fanOut - 1 ) ) ) // completes a node of the pyramid
+            tail->summarize( tail->count - SampleBlock::fanOut, tail->count );
+        ++retained;
+        ++appendedCount;
+    }
+    size_t size() const { return retained; }
+    /// \brief Number of samples appended since the ring was created, including the evicted ones.
+    uint64_t appended() const { return appendedCount; }
+    bool empty() const { return 0 == retained; }
+    double back() const { return tail->value( tail->count - 1 ); }
+    int64_t backTime() const { return tail->times[ tail->count - 1 ]; }
+
+    /// \brief Evict all samples.
+    void clear();
+
+    /// \brief Limit the ring to `maxBlocks` blocks (at least 2), older blocks are evicted immediately.
+    void setMaxBlocks( size_t maxBlocks );
+    size_t maxBlocks() const { return ring.size(); }
+    size_t usedBlocks() const { return used; }
+    /// \brief Evict blocks whose newest sample is more than `duration` (ns) older than the newest sample,
+    /// checked whenever a new block is started. 0 keeps the blocks until the ring is full.
+    void setRetentionTime( int64_t duration ) { retentionTime = duration; }
+
+    /// \brief Insert older samples in front of the oldest one, e.g. history that is loaded after the live data.
+    /// Samples outside the retention time and samples that do not fit into the ring are dropped, the oldest first.
+    /// Time stamps newer than the oldest sample of the ring are clamped to it.
+    /// \param times Time stamps (ns) in ascending order.
+    /// \return The number of samples that were stored, less than `count` if the ring is saturated.
+    size_t prepend( const int64_t *times, const double *values, size_t count );
+
+    /// \brief Fill `snapshot` with a view of the samples from `from` (ns) up to the newest one.
+    /// The view starts with the newest sample at or before `from`, it holds the value at `from`.
+    void snapshot( int64_t from, SampleSnapshot &snapshot ) const;
+
+  private:
+    /// \brief Start a new newest block for a sample at `time` with `value`.
+    void nextBlock( int64_t time, double value );
+    void evictOldest();
+    const SampleBlockPtr &block( size_t age ) const { return ring[ ( head + age ) % ring.size() ]; }
+
+    SampleBlockPool *pool;
+    std::vector< SampleBlockPtr > ring; ///< Fixed size, no allocation while appending
+    size_t head = 0;                    ///< Position of the oldest block in ring
+    size_t used = 0;                    ///< Blocks in use starting at head
+    SampleBlock *tail = nullptr;        ///< Newest block, the one that is appended to
+    size_t retained = 0;
+    uint64_t appendedCount = 0;
+    int64_t retentionTime = 0;
+    double peak = 0.0; ///< Largest magnitude appended to the newest block, the scale of the next one follows it
+};
@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+
+// Element types of the sample store and of the processed frames, selected at compile time by the
+// CMake option SAMPLE_TYPE: "float" (default), "int16" (quantized store, float frames) or "double".
+#if defined( OPENHANTEK_SAMPLE_DOUBLE )
+typedef double StoredSample; ///< Element of the values column of a SampleBlock
+typedef double Sample;       ///< Element of the resampled frames and the processing buffers
+#elif defined( OPENHANTEK_SAMPLE_INT16 )
+typedef int16_t StoredSample;
+typedef float Sample;
+#else
+typedef float StoredSample;
+typedef float Sample;
+#endif
+
+
+/// \brief Converts between values and the stored element type `T`.
+/// Floating point types keep the value, the scale of the block is not used.
+template < typename T, bool quantized = std::is_integral< T >::value > struct SampleCodec {
+    static const bool isQuantized = false;
+    static double scaleFor( double /* peak */ ) { return 1.0; }
+    static T encode( double value, double /* scale */ ) { return T( value ); }
+    static double decode( T stored, double /* scale */ ) { return double( stored ); }
+};
+
+
+/// \brief Integer types store the value in steps of a power of two `scale` that is fixed per block.
+/// The scale leaves at least twice the peak of the previous block as headroom, larger values saturate
+/// until the next block adapts to them.
+template < typename T > struct SampleCodec< T, true > {
+    static const bool isQuantized = true;
+    /// \brief Smallest power of two step that represents +-2 * `peak`, a silent channel gets +-1024.
+    static double scaleFor( double peak ) {
+        int exponent = 0;
+        std::frexp( 2 * ( peak > 0 ? peak : 256.0 ) / std::numeric_limits< T >::max(), &exponent );
+        return std::ldexp( 1.0, exponent );
+    }
+    static T encode( double value, double scale ) {
+        const double steps = std::round( value / scale );
+        return T( std::min( std::max( steps, double( std::numeric_limits< T >::min() ) ),
+                            double( std::numeric_limits< T >::max() ) ) );
+    }
+    static double decode( T stored, double scale ) { return stored * scale; }
+};
+
+typedef SampleCodec< StoredSample > StoredSampleCodec;
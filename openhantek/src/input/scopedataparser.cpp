@@ -0,0 +1,162 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <charconv>
+#include <cstring>
+
+// std::from_chars() for double needs GCC 11 or MSVC 2019, older compilers and Apple's libc++ lack it
+#if !defined( __cpp_lib_to_chars ) || __cpp_lib_to_chars < 201611L
+#define SCOPEDATA_NO_FLOAT_FROM_CHARS
+#include <QByteArray>
+#endif
+
+#include "scopedataparser.h"
+
+
+static const size_t initialTableSize = 256; // power of two
+
+
+static inline const char *skipSpace( const char *pos, const char *end ) {
+    while ( pos < end && ( *pos == ' ' || *pos == '\t' || *pos == '\r' ) )
+        ++pos;
+    return pos;
+}
+
+
+// a name ends at the separator or at white space, trailing white space is not part of the name
+static inline const char *scanName( const char *pos, const char *end ) {
+    while ( pos < end && *pos != ':' && *pos != ',' && *pos != ' ' && *pos != '\t' )
+        ++pos;
+    return pos;
+}
+
+
+static inline const char *parseNumber( const char *pos, const char *end, double &value ) {
+    if ( pos < end && *pos == '+' ) // accepted by QString::toFloat() but not by from_chars()
+        ++pos;
+#ifdef SCOPEDATA_NO_FLOAT_FROM_CHARS
+    // the number ends at the next separator, toDouble() ignores the locale like from_chars() does
+    const char *numberEnd = pos;
+    while ( numberEnd < end && *numberEnd != ',' && *numberEnd != ' ' && *numberEnd != '\t' && *numberEnd != '\r' )
+        ++numberEnd;
+    bool ok = false;
+    value = QByteArray::fromRawData( pos, int( numberEnd - pos ) ).toDouble( &ok );
+    return ok ? numberEnd : nullptr;
+#else
+    std::from_chars_result result = std::from_chars( pos, end, value );
+    return result.ec == std::errc() ? result.ptr : nullptr;
+#endif
+}
+
+
+ScopeDataParser::ScopeDataParser() : table( initialTableSize, 0 ) {}
+
+
+bool ScopeDataParser::parse( const char *begin, const char *end, Line &line ) {
+    line.values.clear();
+    // leading word, e.g. "Time", followed by ':' and the time stamp
+    const char *pos = scanName( skipSpace( begin, end ), end );
+    pos = skipSpace( pos, end );
+    if ( pos >= end || *pos != ':' )
+        return false;
+    pos = parseNumber( skipSpace( pos + 1, end ), end, line.time );
+    if ( !pos )
+        return false;
+    for ( ;; ) {
+        pos = skipSpace( pos, end );
+        if ( pos >= end || *pos != ',' )
+            break;
+        const char *name = skipSpace( pos + 1, end );
+        const char *nameEnd = scanName( name, end );
+        pos = skipSpace( nameEnd, end );
+        if ( nameEnd == name || pos >= end || *pos != ':' )
+            break;
+        const unsigned channel = intern( name, size_t( nameEnd - name ) );
+        ++counts[ channel ];
+        if ( !subscribed[ channel ] ) { // skip the value up to the next separator
+            const char *next = static_cast< const char * >( memchr( pos, ',', size_t( end - pos ) ) );
+            pos = next ? next : end;
+            continue;
+        }
+        double value;
+        pos = parseNumber( skipSpace( pos + 1, end ), end, value );
+        if ( !pos )
+            break;
+        line.values.push_back( { channel, value } );
+    }
+    return true;
+}
+
+
+unsigned ScopeDataParser::intern( const char *name, size_t length ) {
+    const uint32_t h = hash( name, length );
+    size_t index = slot( name, length, h );
+    if ( table[ index ] )
+        return table[ index ] - 1;
+    // new channel, the only path that allocates
+    const unsigned channel = unsigned( names.size() );
+    names.push_back( { uint32_t( arena.size() ), uint32_t( length ) } );
+    hashes.push_back( h );
+    arena.insert( arena.end(), name, name + length );
+    subscribed.push_back( !subscription || subscription( name, length ) );
+    counts.push_back( 0 );
+    table[ index ] = channel + 1;
+    if ( 2 * names.size() > table.size() ) // keep the load factor below 50%
+        grow();
+    return channel;
+}
+
+
+unsigned ScopeDataParser::find( const char *name, size_t length ) const {
+    const uint32_t id = table[ slot( name, length, hash( name, length ) ) ];
+    return id ? id - 1 : invalidChannel;
+}
+
+
+std::string ScopeDataParser::channelName( unsigned channel ) const {
+    if ( channel >= names.size() )
+        return std::string();
+    return std::string( arena.data() + names[ channel ].offset, names[ channel ].length );
+}
+
+
+void ScopeDataParser::setSubscription( Subscription newSubscription ) {
+    subscription = std::move( newSubscription );
+    for ( unsigned channel = 0; channel < names.size(); ++channel )
+        subscribed[ channel ] = !subscription || subscription( arena.data() + names[ channel ].offset, names[ channel ].length );
+}
+
+
+uint32_t ScopeDataParser::hash( const char *name, size_t length ) { // FNV-1a
+    uint32_t h = 2166136261u;
+    for ( size_t i = 0; i < length; ++i ) {
+        h ^= uint8_t( name[ i ] );
+        h *= 16777619u;
+    }
+    return h;
+}
+
+
+size_t ScopeDataParser::slot( const char *name, size_t length, uint32_t h ) const {
+    const size_t mask = table.size() - 1;
+    for ( size_t index = h & mask;; index = ( index + 1 ) & mask ) { // linear probing, the table is never full
+        const uint32_t id = table[ index ];
+        if ( !id )
+            return index;
+        const Name &candidate = names[ id - 1 ];
+        if ( hashes[ id - 1 ] == h && candidate.length == length && 0 == memcmp( arena.data() + candidate.offset, name, length ) )
+            return index;
+    }
+}
+
+
+void ScopeDataParser::grow() {
+    std::vector< uint32_t > newTable( 2 * table.size(), 0 );
+    const size_t mask = newTable.size() - 1;
+    for ( unsigned channel = 0; channel < names.size(); ++channel ) {
+        size_t index = hashes[ channel ] & mask;
+        while ( newTable[ index ] )
+            index = ( index + 1 ) & mask;
+        newTable[ index ] = channel + 1;
+    }
+    table.swap( newTable );
+}
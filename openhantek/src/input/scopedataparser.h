@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+
+/// \brief Single pass parser for the payload of a "ScopeData: " log line.
+///
+/// The payload is `<word>: <time>, <name>: <value>, <name>: <value>, ...`, e.g.
+/// `Time: 12.345, FrameTime: 16.6, GameThread: 9.1`. The raw UTF-8 bytes are walked once, numbers are
+/// converted with std::from_chars and channel names are resolved to dense integer ids by an intern table.
+/// After the names of all channels have been seen once (warm-up) parsing does no heap allocation
+/// and no string compare besides the final memcmp of a hash hit.
+/// The values of channels that are not subscribed are only counted, their bytes are skipped without conversion.
+class ScopeDataParser {
+  public:
+    struct Value {
+        unsigned channel; ///< Dense channel id, see channelName()
+        double value;
+    };
+
+    struct Line {
+        double time = 0.0;
+        std::vector< Value > values; ///< Reused by every parse() call, the capacity is kept
+    };
+
+    /// \brief Decides once per channel name whether its values are parsed.
+    typedef std::function< bool( const char *name, size_t length ) > Subscription;
+
+    ScopeDataParser();
+
+    /// \brief Parse the bytes of one line (without the key and the newline).
+    /// Parsing stops at the first malformed item, the values parsed up to there are kept.
+    /// \return false if the line does not even contain a valid time stamp.
+    bool parse( const char *begin, const char *end, Line &line );
+
+    /// \brief Return the id for a channel name, a new id is assigned to a name that was not seen before.
+    unsigned intern( const char *name, size_t length );
+
+    /// \brief Return the id of a known channel name or `invalidChannel`.
+    unsigned find( const char *name, size_t length ) const;
+
+    unsigned channelCount() const { return unsigned( names.size() ); }
+    std::string channelName( unsigned channel ) const;
+
+    /// \brief Set the subscription for new names and re-evaluate it for all known names.
+    /// Without a subscription all channels are parsed.
+    void setSubscription( Subscription subscription );
+    bool isSubscribed( unsigned channel ) const { return channel < subscribed.size() && subscribed[ channel ]; }
+    /// \brief Number of values seen for `channel`, parsed or skipped.
+    uint64_t valueCount( unsigned channel ) const { return channel < counts.size() ? counts[ channel ] : 0; }
+
+    static const unsigned invalidChannel = ~0u;
+
+  private:
+    struct Name {
+        uint32_t offset; ///< Position in the arena
+        uint32_t length;
+    };
+    static uint32_t hash( const char *name, size_t length );
+    size_t slot( const char *name, size_t length, uint32_t h ) const;
+    void grow();
+
+    std::vector< char > arena;         ///< All channel names back to back
+    std::vector< Name > names;         ///< Indexed by channel id
+    std::vector< uint32_t > table;     ///< Open addressing hash table, channel id + 1, 0 = empty slot
+    std::vector< uint32_t > hashes;    ///< Indexed by channel id, avoids rehashing the names on growth
+    std::vector< uint8_t > subscribed; ///< Indexed by channel id
+    std::vector< uint64_t > counts;    ///< Indexed by channel id
+    Subscription subscription;
+};
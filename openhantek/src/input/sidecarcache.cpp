@@ -0,0 +1,298 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <algorithm>
+#include <cstring>
+#include <set>
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QStandardPaths>
+
+#include "sidecarcache.h"
+
+
+static const uint32_t sidecarMagic = 0x4353484f; // "OHSC", also detects a sidecar of a different byte order
+static const uint32_t sidecarVersion = 2;         // 2: empty columns of covered channels, overlay segments
+static const uint32_t segmentMagic = 0x4745534f; // "OSEG"
+static const uint32_t overlayMagic = 0x5645534f; // "OSEV"
+// The log is identified by a hash of its first bytes, a rotated or rewritten log does not match any more
+static const qint64 identityBytes = 64 << 10;
+
+struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    int64_t modified;  ///< Modification time of the log (ms since epoch) when the sidecar was created
+    uint64_t hash;     ///< FNV-1a of the first hashedSize bytes of the log
+    int64_t hashedSize;
+};
+
+struct SegmentHeader {
+    uint64_t size; ///< Including this header
+    uint32_t magic;
+    uint32_t columns;
+    int64_t begin; ///< Byte range of the log
+    int64_t end;
+};
+
+struct ColumnHeader {
+    uint32_t nameSize;
+    uint32_t reserved;
+    uint64_t count; ///< Followed by the name padded to 8 bytes, count time stamps and count values
+};
+
+static_assert( sizeof( FileHeader ) % 8 == 0 && sizeof( SegmentHeader ) % 8 == 0 && sizeof( ColumnHeader ) % 8 == 0,
+               "the columns of the sidecar must stay 8 byte aligned" );
+
+
+static size_t padded( size_t size ) { return ( size + 7 ) & ~size_t( 7 ); }
+
+
+static uint64_t hashLogStart( const QString &logFileName, qint64 size ) {
+    QFile log( logFileName );
+    if ( !log.open( QIODevice::ReadOnly ) )
+        return 0;
+    const QByteArray start = log.read( size );
+    if ( start.size() != size )
+        return 0;
+    uint64_t hash = 14695981039346656037ull;
+    for ( char c : start ) {
+        hash ^= uint8_t( c );
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+
+SidecarCache::SidecarCache( int verboseLevel ) : verboseLevel( verboseLevel ) {}
+
+
+SidecarCache::~SidecarCache() { close(); }
+
+
+// static
+QString SidecarCache::sidecarFileName( const QString &logFileName ) {
+    const QByteArray path = QFileInfo( logFileName ).absoluteFilePath().toUtf8();
+    return QStandardPaths::writableLocation( QStandardPaths::CacheLocation ) + "/logs/" +
+           QCryptographicHash::hash( path, QCryptographicHash::Sha1 ).toHex() + ".ohsc";
+}
+
+
+qint64 SidecarCache::open( const QString &logFileName ) {
+    close();
+    const QString fileName = sidecarFileName( logFileName );
+    QDir().mkpath( QFileInfo( fileName ).path() );
+    reader.setFileName( fileName );
+    qint64 complete = 0;
+    bool valid = false;
+    if ( reader.open( QIODevice::ReadOnly ) && reader.size() >= qint64( sizeof( FileHeader ) ) ) {
+        mapped = reader.map( 0, reader.size() );
+        if ( mapped && validHeader( mapped, reader.size(), logFileName ) ) {
+            std::vector< SegmentView > all;
+            complete = readSegments( mapped, reader.size(), all );
+            // the contiguous run of segments that ends with the newest one
+            QHash< qint64, size_t > byEnd;
+            size_t newest = 0;
+            for ( size_t index = 0; index < all.size(); ++index ) {
+                if ( all[ index ].overlay || all[ index ].end <= all[ index ].begin )
+                    continue;
+                byEnd.insert( all[ index ].end, index );
+                if ( all[ index ].end > all[ newest ].end )
+                    newest = index;
+            }
+            if ( !byEnd.isEmpty() ) {
+                cached.push_back( all[ newest ] );
+                for ( auto it = byEnd.constFind( cached.back().begin ); it != byEnd.constEnd();
+                      it = byEnd.constFind( cached.back().begin ) )
+                    cached.push_back( all[ it.value() ] );
+                // the re-scanned channels of the run, an overlay beyond its end was written after it
+                const qint64 runBegin = cached.back().begin;
+                const qint64 runEnd = cached.front().end;
+                for ( const SegmentView &segment : all )
+                    if ( segment.overlay && segment.end >= runBegin && segment.end <= runEnd )
+                        cached.push_back( segment );
+                std::stable_sort( cached.begin(), cached.end(),
+                                  []( const SegmentView &a, const SegmentView &b ) { return a.end > b.end; } );
+            }
+            valid = cached.empty() || cached.front().end <= QFileInfo( logFileName ).size();
+        }
+    }
+    if ( !valid ) {
+        if ( verboseLevel > 1 && reader.exists() )
+            qDebug() << "  SidecarCache::open() discards the outdated" << fileName;
+        releaseSegments();
+        reader.close();
+        cached.clear();
+        QFile::remove( fileName );
+        createHeader( logFileName );
+        return 0;
+    }
+    writer.setFileName( fileName );
+    if ( !writer.open( QIODevice::ReadWrite ) ) {
+        releaseSegments();
+        return 0;
+    }
+    if ( writer.size() > complete ) // a torn segment of a crashed session
+        writer.resize( complete );
+    writer.seek( complete );
+    const qint64 resume = cached.empty() ? 0 : cached.front().end;
+    if ( verboseLevel > 1 )
+        qDebug() << "  SidecarCache::open()" << fileName << cached.size() << "segments up to" << resume;
+    return resume;
+}
+
+
+void SidecarCache::close() {
+    releaseSegments();
+    reader.close();
+    writer.close();
+}
+
+
+void SidecarCache::discard( const QString &logFileName ) {
+    close();
+    QFile::remove( sidecarFileName( logFileName ) );
+    createHeader( logFileName );
+}
+
+
+void SidecarCache::releaseSegments() {
+    cached.clear();
+    if ( mapped )
+        reader.unmap( mapped );
+    mapped = nullptr;
+}
+
+
+void SidecarCache::append( qint64 begin, qint64 end, const std::vector< LogBackfill::Column > &columns,
+                           const std::vector< std::string > &covered, bool overlay ) {
+    if ( !writer.isOpen() )
+        return;
+    size_t size = sizeof( SegmentHeader );
+    SegmentHeader header = { 0, overlay ? overlayMagic : segmentMagic, 0, begin, end };
+    std::set< std::string > withSamples;
+    for ( const LogBackfill::Column &column : columns ) {
+        if ( column.times.empty() )
+            continue;
+        size += sizeof( ColumnHeader ) + padded( column.name.size() ) + column.times.size() * ( sizeof( int64_t ) + sizeof( double ) );
+        ++header.columns;
+        withSamples.insert( column.name );
+    }
+    std::vector< const std::string * > empty; // covered, but no samples in this range
+    for ( const std::string &name : covered )
+        if ( !withSamples.count( name ) ) {
+            size += sizeof( ColumnHeader ) + padded( name.size() );
+            ++header.columns;
+            empty.push_back( &name );
+        }
+    header.size = size;
+    segmentBuffer.fill( 0, int( size ) ); // also clears the padding
+    char *p = segmentBuffer.data();
+    memcpy( p, &header, sizeof( header ) );
+    p += sizeof( header );
+    for ( const LogBackfill::Column &column : columns ) {
+        if ( column.times.empty() )
+            continue;
+        const ColumnHeader columnHeader = { uint32_t( column.name.size() ), 0, column.times.size() };
+        memcpy( p, &columnHeader, sizeof( columnHeader ) );
+        p += sizeof( columnHeader );
+        memcpy( p, column.name.data(), column.name.size() );
+        p += padded( column.name.size() );
+        memcpy( p, column.times.data(), column.times.size() * sizeof( int64_t ) );
+        p += column.times.size() * sizeof( int64_t );
+        memcpy( p, column.values.data(), column.values.size() * sizeof( double ) );
+        p += column.values.size() * sizeof( double );
+    }
+    for ( const std::string *name : empty ) {
+        const ColumnHeader columnHeader = { uint32_t( name->size() ), 0, 0 };
+        memcpy( p, &columnHeader, sizeof( columnHeader ) );
+        p += sizeof( columnHeader );
+        memcpy( p, name->data(), name->size() );
+        p += padded( name->size() );
+    }
+    if ( writer.write( segmentBuffer ) != segmentBuffer.size() ) {
+        if ( verboseLevel > 1 )
+            qDebug() << "  SidecarCache::append() failed, caching stopped:" << writer.errorString();
+        writer.close();
+        return;
+    }
+    writer.flush();
+}
+
+
+bool SidecarCache::validHeader( const uchar *data, qint64 size, const QString &logFileName ) const {
+    FileHeader header;
+    if ( size < qint64( sizeof( header ) ) )
+        return false;
+    memcpy( &header, data, sizeof( header ) );
+    if ( header.magic != sidecarMagic || header.version != sidecarVersion )
+        return false;
+    const QFileInfo log( logFileName );
+    if ( log.lastModified().toMSecsSinceEpoch() < header.modified || log.size() < header.hashedSize )
+        return false;
+    return hashLogStart( logFileName, header.hashedSize ) == header.hash;
+}
+
+
+bool SidecarCache::createHeader( const QString &logFileName ) {
+    const QFileInfo log( logFileName );
+    FileHeader header;
+    header.magic = sidecarMagic;
+    header.version = sidecarVersion;
+    header.modified = log.lastModified().toMSecsSinceEpoch();
+    header.hashedSize = qMin( log.size(), identityBytes );
+    header.hash = hashLogStart( logFileName, header.hashedSize );
+    writer.setFileName( sidecarFileName( logFileName ) );
+    if ( !writer.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+        return false;
+    if ( writer.write( reinterpret_cast< const char * >( &header ), sizeof( header ) ) != qint64( sizeof( header ) ) ) {
+        writer.close();
+        return false;
+    }
+    return true;
+}
+
+
+qint64 SidecarCache::readSegments( const uchar *data, qint64 size, std::vector< SegmentView > &segments ) const {
+    qint64 pos = sizeof( FileHeader );
+    while ( size - pos >= qint64( sizeof( SegmentHeader ) ) ) {
+        SegmentHeader header;
+        memcpy( &header, data + pos, sizeof( header ) );
+        if ( ( header.magic != segmentMagic && header.magic != overlayMagic ) || header.size < sizeof( header ) ||
+             header.size % 8 || header.size > uint64_t( size - pos ) )
+            break;
+        const qint64 segmentEnd = pos + qint64( header.size );
+        SegmentView segment = { header.begin, header.end, header.magic == overlayMagic, {} };
+        qint64 p = pos + qint64( sizeof( header ) );
+        bool complete = true;
+        for ( uint32_t column = 0; column < header.columns; ++column ) {
+            ColumnHeader columnHeader;
+            if ( segmentEnd - p < qint64( sizeof( columnHeader ) ) ) {
+                complete = false;
+                break;
+            }
+            memcpy( &columnHeader, data + p, sizeof( columnHeader ) );
+            p += sizeof( columnHeader );
+            const uint64_t nameBytes = padded( columnHeader.nameSize );
+            const uint64_t available = uint64_t( segmentEnd - p );
+            if ( nameBytes > available ||
+                 columnHeader.count > ( available - nameBytes ) / ( sizeof( int64_t ) + sizeof( double ) ) ) {
+                complete = false;
+                break;
+            }
+            const int64_t *times = reinterpret_cast< const int64_t * >( data + p + nameBytes ); // 8 byte aligned
+            segment.columns.push_back( { reinterpret_cast< const char * >( data + p ), columnHeader.nameSize, times,
+                                         reinterpret_cast< const double * >( times + columnHeader.count ),
+                                         size_t( columnHeader.count ) } );
+            p += qint64( nameBytes + columnHeader.count * ( sizeof( int64_t ) + sizeof( double ) ) );
+        }
+        if ( !complete )
+            break;
+        segments.push_back( std::move( segment ) );
+        pos = segmentEnd;
+    }
+    return pos;
+}
@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <QFile>
+#include <QString>
+
+#include "logbackfill.h"
+
+
+/// \brief Binary cache of the samples already parsed from a log file, kept in a sidecar file.
+///
+/// The sidecar is a header that identifies the log (modification time and a hash of its first bytes)
+/// followed by segments. A segment holds the samples parsed from one byte range of the log as columns
+/// (name, time stamps, values) that are 8 byte aligned, so they are used directly from the memory mapped
+/// sidecar on reopen. A segment has a column for every channel that was parsed from its range, an empty one
+/// if the channel has no samples there, so the reader knows which part of the log is cached per channel.
+/// The segments may be written in any order, e.g. newest first by the LogBackfill;
+/// on reopen the contiguous run of segments that ends at the highest log offset is used and the text
+/// is parsed only from there on. Overlay segments add channels that were re-scanned later to a part of that run.
+/// A sidecar that does not match its log any more is discarded.
+class SidecarCache {
+  public:
+    /// \brief Columns of a cached segment, pointing into the mapped sidecar.
+    struct ColumnView {
+        const char *name;
+        size_t nameSize;
+        const int64_t *times;
+        const double *values;
+        size_t count;
+    };
+    struct SegmentView {
+        qint64 begin; ///< Byte range of the log the samples were parsed from
+        qint64 end;
+        bool overlay; ///< Holds re-scanned channels only, see append()
+        std::vector< ColumnView > columns;
+    };
+
+    explicit SidecarCache( int verboseLevel = 0 );
+    ~SidecarCache();
+    SidecarCache( const SidecarCache & ) = delete;
+
+    /// \brief Open or create the sidecar of `logFileName` and map the cached segments.
+    /// \return The log offset where text parsing has to resume, 0 if nothing is cached.
+    qint64 open( const QString &logFileName );
+    void close();
+    bool isOpen() const { return writer.isOpen(); }
+    /// \brief Drop the cached segments and start an empty sidecar, e.g. after the log was rotated or truncated.
+    void discard( const QString &logFileName );
+
+    /// \brief The usable cached segments, newest (highest end) first. Valid until releaseSegments() or close().
+    const std::vector< SegmentView > &segments() const { return cached; }
+    /// \brief Unmap the cached segments once they are loaded, appending continues.
+    void releaseSegments();
+
+    /// \brief Append the samples parsed from the log bytes [begin, end), also if there are none.
+    /// \param covered The channels that were parsed from this range, those without samples get an empty column.
+    /// \param overlay The range is part of the cached run already, `columns` add re-scanned channels to it.
+    void append( qint64 begin, qint64 end, const std::vector< LogBackfill::Column > &columns,
+                 const std::vector< std::string > &covered, bool overlay = false );
+
+    /// \brief Location of the sidecar of a log in the user cache directory.
+    static QString sidecarFileName( const QString &logFileName );
+
+  private:
+    bool validHeader( const uchar *data, qint64 size, const QString &logFileName ) const;
+    bool createHeader( const QString &logFileName );
+    /// \brief Collect the segments of the mapped sidecar.
+    /// \return The size of the complete segments, a torn last segment is cut off.
+    qint64 readSegments( const uchar *data, qint64 size, std::vector< SegmentView > &segments ) const;
+
+    int verboseLevel = 0;
+    QFile reader; ///< Mapped while the cached segments are loaded
+    uchar *mapped = nullptr;
+    QFile writer;
+    std::vector< SegmentView > cached;
+    QByteArray segmentBuffer; ///< Reused by append()
+};
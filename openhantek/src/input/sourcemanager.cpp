@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <algorithm>
+
+#include <QDebug>
+#include <QThread>
+
+#include "sourcemanager.h"
+
+
+SourceManager::SourceManager( int verboseLevel, QObject *parent ) : QObject( parent ), verboseLevel( verboseLevel ) {}
+
+
+SourceManager::~SourceManager() {
+    for ( Entry &entry : sources ) {
+        if ( entry.thread->isRunning() ) {
+            // the tailer and its timers must be destroyed in the thread of the source
+            QMetaObject::invokeMethod( entry.source, "stop", Qt::BlockingQueuedConnection );
+            entry.thread->quit();
+            entry.thread->wait();
+        }
+        delete entry.source;
+        delete entry.thread;
+    }
+}
+
+
+void SourceManager::addSource( SampleSource *source ) {
+    QString prefix = source->prefix();
+    for ( int index = 2; byPrefix.contains( prefix ); ++index )
+        prefix = QString( "%1#%2" ).arg( source->prefix() ).arg( index );
+    byPrefix.insert( prefix, source );
+    source->setPrefix( prefix ); // the subscription patterns match the unique prefix
+    source->setSubscription( patterns );
+
+    QThread *thread = new QThread();
+    thread->setObjectName( "source " + prefix );
+    source->moveToThread( thread );
+    connect( thread, &QThread::started, source, &SampleSource::start );
+    connect( source, &SampleSource::samplesAdded, this, &SourceManager::samplesAdded );
+    connect( source, &SampleSource::statusMessage, this, &SourceManager::statusMessage );
+    connect( source, &SampleSource::channelsAdded, this,
+             [ this, prefix ]( const QStringList &newNames ) { addChannels( prefix, newNames ); } );
+    sources.push_back( { source, thread } );
+    if ( verboseLevel > 1 )
+        qDebug() << " SourceManager::addSource()" << prefix;
+    thread->start();
+}
+
+
+bool SourceManager::snapshot( const QString &name, int64_t duration, SampleSnapshot &snapshot, int64_t &end,
+                              FrameStamps *stamps ) const {
+    const int separator = name.lastIndexOf( ':' ); // channel names never contain ':', prefixes may
+    const SampleSource *source = separator > 0 ? byPrefix.value( name.left( separator ), nullptr ) : nullptr;
+    if ( !source ) {
+        snapshot.clear();
+        return false;
+    }
+    return source->snapshot( name.mid( separator + 1 ), duration, snapshot, end, stamps );
+}
+
+
+void SourceManager::applyRetention( size_t retentionBlocks, size_t budgetBlocks, int64_t retentionTime ) {
+    size_t storing = 0;
+    for ( const Entry &entry : sources )
+        storing += entry.source->storingChannelCount( filter );
+    const size_t maxBlocks = std::min( retentionBlocks, budgetBlocks / std::max( storing, size_t( 1 ) ) );
+    for ( Entry &entry : sources )
+        entry.source->setRetention( maxBlocks, retentionTime );
+    if ( verboseLevel > 2 )
+        qDebug() << "  SourceManager::applyRetention()" << storing << "of" << names.size() << "channels,"
+                 << maxBlocks << "blocks each,"
+                 << retentionTime * 1e-9 << "s";
+}
+
+
+void SourceManager::setSubscription( const QStringList &patterns ) {
+    this->patterns = patterns;
+    std::vector< std::string > list;
+    for ( const QString &pattern : patterns )
+        list.push_back( pattern.toStdString() );
+    filter = ChannelFilter( std::move( list ) );
+    for ( Entry &entry : sources )
+        QMetaObject::invokeMethod( entry.source, "setSubscription", Qt::QueuedConnection, Q_ARG( QStringList, patterns ) );
+    if ( verboseLevel > 1 )
+        qDebug() << " SourceManager::setSubscription()" << patterns;
+}
+
+
+void SourceManager::refresh() {
+    for ( Entry &entry : sources )
+        QMetaObject::invokeMethod( entry.source, "refresh", Qt::QueuedConnection );
+}
+
+
+void SourceManager::addChannels( const QString &prefix, const QStringList &newNames ) {
+    for ( const QString &name : newNames )
+        names.push_back( qualifiedName( prefix, name ) );
+    emit channelsChanged();
+}
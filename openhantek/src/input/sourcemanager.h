@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <vector>
+
+#include "samplesource.h"
+
+class QThread;
+
+
+/// \brief Runs any number of sample sources in parallel, each one in its own thread.
+///
+/// The channels of all sources are merged into one list of qualified names "prefix:name".
+/// The sources do not share any state, a slow or busy source never blocks the others.
+/// The manager itself lives in the thread of DsoInput.
+class SourceManager : public QObject {
+    Q_OBJECT
+
+  public:
+    explicit SourceManager( int verboseLevel = 0, QObject *parent = nullptr );
+    /// \brief Stops all sources and waits for their threads.
+    ~SourceManager() override;
+
+    /// \brief Take ownership of `source`, move it into a new thread and start it.
+    /// The prefix of the source is made unique if another source already uses it.
+    /// The source starts with the current subscription.
+    void addSource( SampleSource *source );
+    size_t sourceCount() const { return sources.size(); }
+
+    /// \brief Join prefix and channel name to the name shown to the user.
+    static QString qualifiedName( const QString &prefix, const QString &name ) { return prefix + ':' + name; }
+
+    /// \brief Fill `snapshot` with the samples of the last `duration` ns of the qualified channel `name`.
+    /// \param end Set to the time (ns) of the newest sample of the source of the channel.
+    /// \param stamps If set, raised to the read and parsed times of the source, see SampleSource::snapshot().
+    bool snapshot( const QString &name, int64_t duration, SampleSnapshot &snapshot, int64_t &end,
+                   FrameStamps *stamps = nullptr ) const;
+    /// \brief The qualified names of the channels of all sources in the order of their discovery.
+    const QVector< QString > &channelNames() const { return names; }
+
+    /// \brief Split the memory budget evenly over the channels that store samples, i.e. the subscribed ones and
+    /// those that still hold samples from an earlier subscription. Call it again when the subscription changed.
+    /// \param retentionBlocks Blocks per channel that are needed for the retention samples.
+    /// \param budgetBlocks Blocks that are allowed for all channels together.
+    /// \param retentionTime Samples older than this (ns) are evicted block wise, 0 for no time limit.
+    void applyRetention( size_t retentionBlocks, size_t budgetBlocks, int64_t retentionTime );
+
+    /// \brief Subscribe the channels whose qualified names match one of the wildcard `patterns` in all sources.
+    void setSubscription( const QStringList &patterns );
+    const QStringList &subscription() const { return patterns; }
+
+  public slots:
+    /// \brief Ask all sources to look for new data now.
+    void refresh();
+
+  signals:
+    void samplesAdded();    ///< At least one source has appended new samples
+    void channelsChanged(); ///< channelNames() has grown
+    void statusMessage( const QString &message, int timeout );
+
+  private:
+    void addChannels( const QString &prefix, const QStringList &newNames );
+
+    struct Entry {
+        SampleSource *source;
+        QThread *thread;
+    };
+    std::vector< Entry > sources;
+    QHash< QString, SampleSource * > byPrefix;
+    QVector< QString > names;
+    QStringList patterns;
+    ChannelFilter filter; ///< Of `patterns`, the sources apply a subscription only later in their threads
+    int verboseLevel = 0;
+};
@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+// Framed binary protocol of the streaming input, shared by StreamSource and the client in ../../tools.
+// No Qt dependency, this header can be copied into a producer (e.g. a game) together with scopestreamclient.h.
+//
+// Every message is a frame: uint32 payload size | uint8 type | payload. All values are little endian.
+//   HELLO    uint32 magic | uint16 version                                 (optional, first message)
+//   DECLARE  uint16 channel | uint16 name size | name (UTF-8)              (before the first sample of a channel)
+//   SAMPLES  int64 timestamp (ns) | uint16 count | count * ( uint16 channel | float32 value )
+// Channel ids are chosen by the producer and are only valid within one connection.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+
+namespace ScopeStream {
+
+static const uint32_t magic = 0x5053484f; // "OHSP"
+static const uint16_t version = 1;
+
+enum MessageType : uint8_t { HELLO = 1, DECLARE = 2, SAMPLES = 3 };
+
+static const size_t headerSize = 5;
+static const size_t sampleSize = 6;          ///< channel + value in a SAMPLES message
+static const uint32_t maxPayload = 1u << 20; ///< Larger frames are a protocol error
+static const uint16_t maxSamplesPerFrame = 65535;
+
+inline void put16( uint8_t *p, uint16_t v ) {
+    p[ 0 ] = uint8_t( v );
+    p[ 1 ] = uint8_t( v >> 8 );
+}
+inline void put32( uint8_t *p, uint32_t v ) {
+    put16( p, uint16_t( v ) );
+    put16( p + 2, uint16_t( v >> 16 ) );
+}
+inline void put64( uint8_t *p, uint64_t v ) {
+    put32( p, uint32_t( v ) );
+    put32( p + 4, uint32_t( v >> 32 ) );
+}
+inline uint16_t get16( const uint8_t *p ) { return uint16_t( p[ 0 ] | p[ 1 ] << 8 ); }
+inline uint32_t get32( const uint8_t *p ) { return uint32_t( get16( p ) ) | uint32_t( get16( p + 2 ) ) << 16; }
+inline uint64_t get64( const uint8_t *p ) { return uint64_t( get32( p ) ) | uint64_t( get32( p + 4 ) ) << 32; }
+inline void putFloat( uint8_t *p, float v ) {
+    uint32_t bits;
+    memcpy( &bits, &v, sizeof( bits ) );
+    put32( p, bits );
+}
+inline float getFloat( const uint8_t *p ) {
+    uint32_t bits = get32( p );
+    float v;
+    memcpy( &v, &bits, sizeof( v ) );
+    return v;
+}
+
+
+/// \brief Builds frames into a reusable byte buffer.
+class Encoder {
+  public:
+    void hello() {
+        uint8_t *p = frame( HELLO, 6 );
+        put32( p, magic );
+        put16( p + 4, version );
+    }
+
+    void declare( uint16_t channel, const std::string &name ) {
+        const uint16_t size = uint16_t( std::min< size_t >( name.size(), 65535 ) );
+        uint8_t *p = frame( DECLARE, 4u + size );
+        put16( p, channel );
+        put16( p + 2, size );
+        memcpy( p + 4, name.data(), size );
+    }
+
+    /// \brief Start a SAMPLES frame, add values with addSample() and close it with endSamples().
+    void beginSamples( int64_t timestamp ) {
+        samplesStart = buffer.size();
+        uint8_t *p = frame( SAMPLES, 10 );
+        put64( p, uint64_t( timestamp ) );
+        put16( p + 8, 0 );
+        samplesCount = 0;
+    }
+    /// \return false if the frame is full, then call endSamples() and start a new one.
+    bool addSample( uint16_t channel, float value ) {
+        if ( samplesCount == maxSamplesPerFrame )
+            return false;
+        const size_t pos = buffer.size();
+        buffer.resize( pos + sampleSize );
+        put16( &buffer[ pos ], channel );
+        putFloat( &buffer[ pos + 2 ], value );
+        ++samplesCount;
+        return true;
+    }
+    void endSamples() {
+        put32( &buffer[ samplesStart ], uint32_t( 10 + samplesCount * sampleSize ) );
+        put16( &buffer[ samplesStart + headerSize + 8 ], samplesCount );
+    }
+
+    const uint8_t *data() const { return buffer.data(); }
+    size_t size() const { return buffer.size(); }
+    void clear() { buffer.clear(); } ///< Keeps the capacity
+
+  private:
+    uint8_t *frame( MessageType type, uint32_t payloadSize ) {
+        const size_t pos = buffer.size();
+        buffer.resize( pos + headerSize + payloadSize );
+        put32( &buffer[ pos ], payloadSize );
+        buffer[ pos + 4 ] = type;
+        return &buffer[ pos + headerSize ];
+    }
+
+    std::vector< uint8_t > buffer;
+    size_t samplesStart = 0;
+    uint16_t samplesCount = 0;
+};
+
+} // namespace ScopeStream
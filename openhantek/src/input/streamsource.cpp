@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <QDebug>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QMutexLocker>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+#include "streamprotocol.h"
+#include "streamsource.h"
+
+using namespace ScopeStream;
+
+
+StreamSource::StreamSource( const QString &address, const QString &prefix, int verboseLevel )
+    : SampleSource( prefix, verboseLevel ), serverAddress( address ) {}
+
+
+StreamSource::~StreamSource() = default;
+
+
+void StreamSource::start() {
+    bool listening;
+    if ( serverAddress.startsWith( "tcp:" ) ) {
+        tcpServer.reset( new QTcpServer() );
+        connect( tcpServer.get(), &QTcpServer::newConnection, this, &StreamSource::acceptConnections );
+        listening = tcpServer->listen( QHostAddress::LocalHost, quint16( serverAddress.mid( 4 ).toUInt() ) );
+    } else {
+        localServer.reset( new QLocalServer() );
+        connect( localServer.get(), &QLocalServer::newConnection, this, &StreamSource::acceptConnections );
+        QLocalServer::removeServer( serverAddress ); // stale socket file of a crashed session
+        listening = localServer->listen( serverAddress );
+    }
+    if ( !listening ) {
+        emit statusMessage( tr( "Could not listen on %1" ).arg( serverAddress ), 0 );
+        if ( verboseLevel > 1 )
+            qDebug() << "  StreamSource::start() could not listen on" << serverAddress;
+    } else if ( verboseLevel > 1 )
+        qDebug() << "  StreamSource::start() listening on" << serverAddress;
+}
+
+
+void StreamSource::stop() {
+    const QList< QIODevice * > sockets = clients.keys();
+    clients.clear(); // before deleting, a socket may emit disconnected() on destruction
+    qDeleteAll( sockets );
+    localServer.reset();
+    tcpServer.reset();
+}
+
+
+void StreamSource::acceptConnections() {
+    while ( localServer && localServer->hasPendingConnections() )
+        addClient( localServer->nextPendingConnection() );
+    while ( tcpServer && tcpServer->hasPendingConnections() ) {
+        QTcpSocket *socket = tcpServer->nextPendingConnection();
+        socket->setSocketOption( QAbstractSocket::LowDelayOption, 1 );
+        addClient( socket );
+    }
+}
+
+
+void StreamSource::addClient( QIODevice *socket ) {
+    socket->setParent( nullptr ); // owned by clients, deleted on disconnect or stop()
+    clients.insert( socket, Client() );
+    connect( socket, &QIODevice::readyRead, this, [ this, socket ]() { readClient( socket ); } );
+    auto disconnected = [ this, socket ]() {
+        if ( clients.remove( socket ) )
+            socket->deleteLater();
+    };
+    if ( QLocalSocket *local = qobject_cast< QLocalSocket * >( socket ) )
+        connect( local, &QLocalSocket::disconnected, this, disconnected );
+    else if ( QTcpSocket *tcp = qobject_cast< QTcpSocket * >( socket ) )
+        connect( tcp, &QTcpSocket::disconnected, this, disconnected );
+    emit statusMessage( tr( "%1: producer connected" ).arg( prefix() ), 2000 );
+}
+
+
+void StreamSource::readClient( QIODevice *socket ) {
+    auto it = clients.find( socket );
+    if ( it == clients.end() )
+        return;
+    const int64_t readTime = FrameTrace::now();
+    it->buffer.append( socket->readAll() );
+    bool ok;
+    {
+        QMutexLocker locker( &mutex ); // one lock per received batch, not per sample
+        ok = decode( *it );
+    }
+    if ( !ok ) {
+        emit statusMessage( tr( "%1: protocol error, connection closed" ).arg( prefix() ), 0 );
+        clients.erase( it );
+        socket->deleteLater();
+    }
+    publish( readTime );
+}
+
+
+bool StreamSource::decode( Client &client ) {
+    const uint8_t *data = reinterpret_cast< const uint8_t * >( client.buffer.constData() );
+    const size_t size = size_t( client.buffer.size() );
+    size_t pos = 0;
+    while ( size - pos >= headerSize ) {
+        const uint32_t payloadSize = get32( data + pos );
+        if ( payloadSize > maxPayload )
+            return false;
+        if ( size - pos < headerSize + payloadSize ) // wait for the rest of the frame
+            break;
+        const uint8_t *payload = data + pos + headerSize;
+        switch ( data[ pos + 4 ] ) {
+        case HELLO:
+            if ( payloadSize < 6 || get32( payload ) != magic || get16( payload + 4 ) > version )
+                return false;
+            break;
+        case DECLARE:
+            if ( !decodeDeclare( client, payload, payloadSize ) )
+                return false;
+            break;
+        case SAMPLES:
+            if ( !decodeSamples( client, payload, payloadSize ) )
+                return false;
+            break;
+        default: // unknown messages of newer producers are skipped
+            break;
+        }
+        pos += headerSize + payloadSize;
+    }
+    client.buffer.remove( 0, int( pos ) );
+    return true;
+}
+
+
+bool StreamSource::decodeDeclare( Client &client, const uint8_t *payload, uint32_t size ) {
+    if ( size < 4 || size < 4u + get16( payload + 2 ) )
+        return false;
+    const uint16_t id = get16( payload );
+    const QString name = QString::fromUtf8( reinterpret_cast< const char * >( payload + 4 ), get16( payload + 2 ) );
+    if ( name.isEmpty() || name.contains( ':' ) )
+        return false;
+    auto known = channelIds.constFind( name );
+    const unsigned channelId = known != channelIds.constEnd() ? known.value() : unsigned( channelIds.size() );
+    channelIds.insert( name, channelId );
+    if ( id >= client.byId.size() )
+        client.byId.resize( id + 1u, nullptr );
+    client.byId[ id ] = addChannel( channelId, name );
+    return true;
+}
+
+
+bool StreamSource::decodeSamples( Client &client, const uint8_t *payload, uint32_t size ) {
+    if ( size < 10 )
+        return false;
+    const uint16_t count = get16( payload + 8 );
+    if ( size < 10 + count * sampleSize )
+        return false;
+    const int64_t time = int64_t( get64( payload ) );
+    const uint8_t *sample = payload + 10;
+    for ( uint16_t i = 0; i < count; ++i, sample += sampleSize ) {
+        const uint16_t id = get16( sample );
+        SampleData *sampleData = id < client.byId.size() ? client.byId[ id ] : nullptr;
+        if ( !sampleData || !sampleData->subscribed ) // not declared or not subscribed, skip it
+            continue;
+        sampleData->addData( time, getFloat( sample + 2 ) );
+    }
+    return true;
+}
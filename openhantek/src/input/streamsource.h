@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <memory>
+#include <vector>
+
+#include "samplesource.h"
+
+class QIODevice;
+class QLocalServer;
+class QTcpServer;
+
+
+/// \brief Accepts producers that stream samples in the framed binary protocol of streamprotocol.h.
+///
+/// The source listens on a local socket (Unix domain socket, named pipe on Windows) or on a loopback TCP port.
+/// Several producers may be connected at the same time, channels with the same name share one SampleData.
+/// Every received batch is published at once, there is no polling and no text parsing on this path.
+class StreamSource : public SampleSource {
+    Q_OBJECT
+
+  public:
+    /// \param address "tcp:<port>" for loopback TCP, otherwise the name or path of the local socket.
+    StreamSource( const QString &address, const QString &prefix, int verboseLevel = 0 );
+    ~StreamSource() override;
+
+    const QString &address() const { return serverAddress; }
+
+  public slots:
+    void start() override;
+    void stop() override;
+
+  private slots:
+    void acceptConnections();
+
+  private:
+    /// \brief Per connection state, channel ids are chosen by the producer.
+    struct Client {
+        QByteArray buffer;                ///< Received bytes of incomplete frames
+        std::vector< SampleData * > byId; ///< Producer channel id -> channel
+    };
+    void addClient( QIODevice *socket );
+    void readClient( QIODevice *socket );
+    /// \brief Decode all complete frames of the client buffer.
+    /// \return false on a protocol error, then the connection is closed.
+    bool decode( Client &client );
+    bool decodeDeclare( Client &client, const uint8_t *payload, uint32_t size );
+    bool decodeSamples( Client &client, const uint8_t *payload, uint32_t size );
+
+    QString serverAddress;
+    std::unique_ptr< QLocalServer > localServer;
+    std::unique_ptr< QTcpServer > tcpServer;
+    QHash< QIODevice *, Client > clients;
+    QHash< QString, unsigned > channelIds; ///< Channel name -> channel id of this source
+};
@@ -37,6 +37,7 @@
 // #include "post/mathchannelgenerator.h"
 #include "post/postprocessing.h"
 #include "post/spectrumgenerator.h"
+#include "utils/frametrace.h"
 
 // Exporter
 #include "exporting/exportcsv.h"
@@ -46,6 +47,7 @@
 
 // GUI
 #include "mainwindow.h"
+#include "renderscheduler.h"
 //#include "selectdevice/selectsupporteddevice.h"
 
 // OpenGL setup
@@ -83,6 +85,9 @@ public:
     bool resetSettings = false;
 
     QString configFileName = QString();
+    QStringList logFiles;
+    QStringList streams;
+    QString traceFile = QString();
 };
 
 void ParseCommandLine( int argc, char *argv[], InitializeArgs& Args )
@@ -166,6 +171,18 @@ void ParseCommandLine( int argc, char *argv[], InitializeArgs& Args )
                 "verbose", QCoreApplication::translate( "main", "Verbose tracing of program startup, ui and processing steps" ),
                 QCoreApplication::translate( "main", "Level" ) );
     p.addOption( verboseOption );
+    QCommandLineOption logOption(
+                { "l", "log" }, QCoreApplication::translate( "main", "Follow a log file, repeat to follow several files in parallel" ),
+                QCoreApplication::translate( "main", "[Prefix=]File" ) );
+    p.addOption( logOption );
+    QCommandLineOption streamOption(
+                "stream", QCoreApplication::translate( "main", "Accept binary sample streams on a local socket or on tcp:<port>, repeatable" ),
+                QCoreApplication::translate( "main", "[Prefix=]Address" ) );
+    p.addOption( streamOption );
+    QCommandLineOption traceOption(
+                "trace", QCoreApplication::translate( "main", "Record the latency of every frame and stage, write it as Chrome trace JSON on exit" ),
+                QCoreApplication::translate( "main", "File" ) );
+    p.addOption( traceOption );
     p.process( parserApp );
     if ( p.isSet( configFileOption ) )
         Args.configFileName = p.value( "config" );
@@ -183,6 +200,10 @@ void ParseCommandLine( int argc, char *argv[], InitializeArgs& Args )
     if ( p.isSet( verboseOption ) )
         verboseLevel = p.value( "verbose" ).toInt();
     Args.resetSettings = p.isSet( resetSettingsOption );
+    Args.logFiles = p.values( logOption );
+    Args.streams = p.values( streamOption );
+    if ( p.isSet( traceOption ) )
+        Args.traceFile = p.value( "trace" );
     // ... and forget the no more needed variables
 }
 
@@ -336,6 +357,7 @@ int main( int argc, char *argv[] ) {
     QCoreApplication::setApplicationName( "OpenHantek6022" );
     QCoreApplication::setApplicationVersion( VERSION );
     QCoreApplication::setAttribute( Qt::AA_UseHighDpiPixmaps, true );
+    QCoreApplication::setAttribute( Qt::AA_ShareOpenGLContexts, true ); // the scopes share their vertex buffer
 #if ( QT_VERSION >= QT_VERSION_CHECK( 5, 6, 0 ) )
     QCoreApplication::setAttribute( Qt::AA_EnableHighDpiScaling, true );
 #endif
@@ -348,6 +370,9 @@ int main( int argc, char *argv[] ) {
     ParseCommandLine(argc, argv, Args);
 
     QApplication openHantekApplication( argc, argv );
+    QThread::currentThread()->setObjectName( "GUI" ); // names the thread in the latency trace
+    if ( !Args.traceFile.isEmpty() )
+        FrameTrace::instance().startRecording( Args.traceFile );
 
     // Qt5 linux styles ("Breeze", "Windows" or "Fusion")
     // Linux default:   "Breeze" (screen is taller compared to the other two styles)
@@ -383,6 +408,10 @@ int main( int argc, char *argv[] ) {
     settings.view.theme = Args.theme;
     // remember the actual fontsize setting
     settings.view.fontSize = Args.fontSize;
+    if ( !Args.logFiles.isEmpty() ) // command line overrides the log files of the last session
+        settings.scope.input.logFiles = Args.logFiles;
+    if ( !Args.streams.isEmpty() )
+        settings.scope.input.streams = Args.streams;
 
 
     QThread dsoControlThread;
@@ -420,8 +449,15 @@ int main( int argc, char *argv[] ) {
     postProcessing.registerProcessor( &graphGenerator );
 
     postProcessing.moveToThread( &postProcessingThread );
-    QObject::connect( &dsoControl, &DsoInput::samplesAvailable, &postProcessing, &PostProcessing::input );
+    // a bounded mailbox instead of a queued argument per frame, stale frames never pile up in the event queue
+    postProcessing.setMailbox( &dsoControl.frames() );
+    QObject::connect( &dsoControl, &DsoInput::framesAvailable, &postProcessing, &PostProcessing::receive );
     QObject::connect( &postProcessing, &PostProcessing::processingFinished, &exportRegistry, &ExporterRegistry::input, Qt::DirectConnection );
+    // the display takes at most one frame per screen refresh, the post processing waits for it
+    RenderScheduler renderScheduler( verboseLevel );
+    postProcessing.setPaced( true );
+    QObject::connect( &postProcessing, &PostProcessing::processingFinished, &renderScheduler, &RenderScheduler::input );
+    QObject::connect( &renderScheduler, &RenderScheduler::frameWanted, &postProcessing, &PostProcessing::frameShown );
     QObject::connect( &dsoControl, &DsoInput::start, &dsoControl, &DsoInput::restartSampling);
     dsoControl.StartSample();
 
@@ -431,8 +467,9 @@ int main( int argc, char *argv[] ) {
     if ( verboseLevel )
         qDebug() << startupTime.elapsed() << "ms:"
                  << "create main window";
-    MainWindow openHantekMainWindow( &dsoControl, &settings, &exportRegistry );
-    QObject::connect( &postProcessing, &PostProcessing::processingFinished, &openHantekMainWindow, &MainWindow::showNewData );
+    MainWindow openHantekMainWindow( &dsoControl, &settings, &exportRegistry, &renderScheduler );
+    QObject::connect( &renderScheduler, &RenderScheduler::show, &openHantekMainWindow, &MainWindow::showNewData );
+    QObject::connect( &openHantekMainWindow, &MainWindow::framePresented, &renderScheduler, &RenderScheduler::presented );
     QObject::connect( &exportRegistry, &ExporterRegistry::exporterProgressChanged, &openHantekMainWindow,
                       &MainWindow::exporterProgressChanged );
     QObject::connect( &exportRegistry, &ExporterRegistry::exporterStatusChanged, &openHantekMainWindow,
@@ -491,6 +528,9 @@ int main( int argc, char *argv[] ) {
     if ( verboseLevel < 2 )
         std::cerr << "after "; // 4th part
 
+    if ( !Args.traceFile.isEmpty() && !FrameTrace::instance().writeRecording() )
+        qWarning() << "Could not write the trace" << Args.traceFile;
+
     //    dsoControl.prepareForShutdown();
 
     return appStatus;
@@ -4,6 +4,7 @@
 #include "iconfont/QtAwesome.h"
 #include "ui_mainwindow.h"
 
+#include "DiagnosticsDock.h"
 #include "HorizontalDock.h"
 #include "SpectrumDock.h"
 #include "TriggerDock.h"
@@ -37,7 +38,8 @@
 
 #include <input/dsoinput.h>
 
-MainWindow::MainWindow( DsoInput *dsoControl, DsoSettings *settings, ExporterRegistry *exporterRegistry, QWidget *parent )
+MainWindow::MainWindow( DsoInput *dsoControl, DsoSettings *settings, ExporterRegistry *exporterRegistry,
+                        const RenderScheduler *renderScheduler, QWidget *parent )
     : QMainWindow( parent ), ui( new Ui::MainWindow ), dsoSettings( settings ), exporterRegistry( exporterRegistry ) {
 
     if ( dsoSettings->scope.verboseLevel > 1 )
@@ -215,6 +217,12 @@ MainWindow::MainWindow( DsoInput *dsoControl, DsoSettings *settings, ExporterReg
     //addDockWidget( Qt::RightDockWidgetArea, triggerDock );
     //addDockWidget( Qt::RightDockWidgetArea, spectrumDock );
 
+    // hidden unless the user asks for it or the saved state shows it
+    DiagnosticsDock *diagnosticsDock = new DiagnosticsDock( scope, &dsoControl->frames(), renderScheduler, this );
+    addDockWidget( Qt::RightDockWidgetArea, diagnosticsDock );
+    diagnosticsDock->hide();
+    ui->menuView->addAction( diagnosticsDock->toggleViewAction() );
+
     restoreGeometry( dsoSettings->mainWindowGeometry );
     restoreState( dsoSettings->mainWindowState );
 
@@ -230,12 +238,14 @@ MainWindow::MainWindow( DsoInput *dsoControl, DsoSettings *settings, ExporterReg
     }
     connect(dsoControl, &DsoInput::newChannelData, voltageDock, &VoltageDock::onNewChannelData);
     connect(dsoControl, &DsoInput::newChannelData2, voltageDock, &VoltageDock::onNewChannelData2);
+    // only the selected channels (and the configured patterns) are parsed and stored
+    connect(voltageDock, &VoltageDock::selectedChannelChanged, dsoControl, &DsoInput::updateSubscription);
+    connect(voltageDock, &VoltageDock::usedChannelChanged, dsoControl, &DsoInput::updateSubscription);
 
     // Connect signals that display text in statusbar
-//    connect( dsoControl, &HantekDsoControl::statusMessage, [ this ]( QString text, int timeout ) {
-//        ui->actionManualCommand->setChecked( false );
-//        statusBar()->showMessage( text, timeout );
-//    } );
+    // the sources emit it from their threads, the context object queues the call to the GUI thread
+    connect( dsoControl, &DsoInput::statusMessage, this,
+             [ this ]( QString text, int timeout ) { statusBar()->showMessage( text, timeout ); } );
     dsoControl->setSamplerate( dsoSettings->scope.horizontal.samplerate );
     // Connect signals to DSO controller and widget
     connect( horizontalDock, &HorizontalDock::samplerateChanged, [ dsoControl, this ]() {
@@ -279,6 +289,7 @@ MainWindow::MainWindow( DsoInput *dsoControl, DsoSettings *settings, ExporterReg
 //    // should we send the smooth mode also to dsoWidget?
 //    connect( triggerDock, &TriggerDock::slopeChanged, dsoControl, &DsoInput::setTriggerSlope );
 //    connect( triggerDock, &TriggerDock::slopeChanged, dsoWidget, &DsoWidget::updateTriggerSlope );
+    connect( dsoWidget, &DsoWidget::framePresented, this, &MainWindow::framePresented );
     connect( dsoWidget, &DsoWidget::triggerPositionChanged, dsoControl, &DsoInput::setTriggerPosition );
     connect( dsoWidget, &DsoWidget::triggerLevelChanged, dsoControl, &DsoInput::setTriggerLevel );
 
@@ -22,6 +22,7 @@ class VoltageDock;
 
 
 class DsoInput;
+class RenderScheduler;
 namespace Ui {
 class MainWindow;
 }
@@ -34,7 +35,7 @@ class MainWindow : public QMainWindow {
 
   public:
     explicit MainWindow( DsoInput *dsoControl, DsoSettings *dsoSettings, ExporterRegistry *exporterRegistry,
-                         QWidget *parent = nullptr );
+                         const RenderScheduler *renderScheduler = nullptr, QWidget *parent = nullptr );
     ~MainWindow() override;
     QElapsedTimer elapsedTime;
 
@@ -69,4 +70,5 @@ class MainWindow : public QMainWindow {
 
   signals:
     void settingsLoaded( DsoSettingsScope *scope, const Dso::ControlSpecification *spec );
+    void framePresented(); ///< See DsoWidget::framePresented()
 };
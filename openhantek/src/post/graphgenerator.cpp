@@ -2,6 +2,8 @@
 
 #include <QDebug>
 #include <QMutex>
+#include <algorithm>
+#include <cmath>
 #include <math.h>
 
 #include "graphgenerator.h"
@@ -50,232 +52,336 @@ void GraphGenerator::prepareSinc( void ) {
 }
 
 
-void GraphGenerator::process( PPresult *result ) {
+void GraphGenerator::prepare( PPresult *result ) {
     if ( scope->verboseLevel > 4 )
-        qDebug() << "    GraphGenerator::process()" << result->tag;
+        qDebug() << "    GraphGenerator::prepare()" << result->tag;
+    // the channel tasks fill their own elements only, the vectors are sized before them
+    result->vaChannelVoltage.resize( scope->voltage.size() );
+    result->vaChannelZoom.resize( scope->voltage.size() );
+    resample.resize( scope->voltage.size() );
+    zoomMinima.resize( scope->voltage.size() );
+    zoomMaxima.resize( scope->voltage.size() );
     if ( scope->horizontal.format == Dso::GraphFormat::TY ) {
         ready = true;
-        generateGraphsTYvoltage( result );
-        generateGraphsTYspectrum( result );
-    } else
-        generateGraphsXY( result );
+        result->vaChannelHistogram.resize( scope->voltage.size() );
+        result->vaChannelSpectrum.resize( scope->spectrum.size() );
+        // a rolling trace only moves to the left, the scopes keep its vertices and append the new samples
+        result->rolling = scope->trigger.mode == Dso::TriggerMode::ROLL && !result->triggeredPosition && !scope->histogram &&
+                          !view->digitalPhosphor &&
+                          ( view->interpolation == Dso::INTERPOLATION_OFF || view->interpolation == Dso::INTERPOLATION_LINEAR );
+        for ( ChannelID channel = 0; channel < result->channelCount() && result->rolling; ++channel )
+            result->rolling = result->data( channel )->envelopeMin.samples->empty(); // columns do not roll by one
+    } else {
+        // Delete all spectrum graphs
+        for ( ChannelGraph &data : result->vaChannelSpectrum )
+            data.clear();
+    }
 }
 
 
-void GraphGenerator::generateGraphsTYvoltage( PPresult *result ) {
+void GraphGenerator::processChannel( PPresult *result, ChannelID channel ) {
+    if ( channel >= scope->voltage.size() )
+        return;
+    if ( scope->horizontal.format == Dso::GraphFormat::TY ) {
+        generateGraphTYvoltage( result, channel );
+        if ( channel < scope->spectrum.size() )
+            generateGraphTYspectrum( result, channel );
+    } else if ( channel % 2 == 0 ) // pairs of channels
+        generateGraphXY( result, channel );
+}
+
+
+void GraphGenerator::generateGraphTYvoltage( PPresult *result, ChannelID channel ) {
     if ( scope->verboseLevel > 5 )
-        qDebug() << "     GraphGenerator::generateGraphsTYvoltage()" << result->tag;
-    result->vaChannelVoltage.resize( scope->voltage.size() );
-    result->vaChannelHistogram.resize( scope->voltage.size() );
+        qDebug() << "     GraphGenerator::generateGraphTYvoltage()" << channel << result->tag;
     bool interpolationStep = view->interpolation == Dso::INTERPOLATION_STEP;
     bool interpolationSinc = view->interpolation == Dso::INTERPOLATION_SINC;
-    for ( ChannelID channel = 0; channel < scope->voltage.size(); ++channel ) {
-        ChannelGraph &graphVoltage = result->vaChannelVoltage[ channel ];
-        ChannelGraph &graphHistogram = result->vaChannelHistogram[ channel ];
-        const SampleValues &sampleValues = useVoltSamplesOf( channel, result, scope );
-
-        // Check if this channel is used and available at the data analyzer
-        if (!sampleValues.samples || sampleValues.samples->empty() ) {
-            // Delete all vector arrays
-            graphVoltage.clear();
-            graphHistogram.clear();
-            continue;
-        }
+    ChannelGraph &graphVoltage = result->vaChannelVoltage[ channel ];
+    ChannelGraph &graphHistogram = result->vaChannelHistogram[ channel ];
+    const SampleValues &sampleValues = useVoltSamplesOf( channel, result, scope );
+    std::vector< Sample > &resample = this->resample[ channel ];
+
+    // Check if this channel is used and available at the data analyzer, a rolling trace is drawn by the scopes
+    if ( !sampleValues.samples || sampleValues.samples->empty() || result->rolling ) {
+        // Delete all vector arrays
+        graphVoltage.clear();
+        graphHistogram.clear();
+        result->vaChannelZoom[ channel ].clear();
+        return;
+    }
 
-        // time distance between sampling points
-        double horizontalFactor = ( sampleValues.interval / scope->horizontal.timebase );
-        // printf( "hF: %g\n", horizontalFactor );
-        unsigned dotsOnScreen = unsigned( ceil( DIVS_TIME / horizontalFactor ) );
-        unsigned preTrigSamples = unsigned( scope->trigger.position * dotsOnScreen );
-        // align displayed trace with trigger mark on screen ...
-        // ... also if trig pos or time/div was changed on a "frozen" or single trace
-        int leftmostPosition = 0;                 // start position on display
-        int leftmostSample = 0;
-        if (dotsOnScreen < sampleValues.samples->size())
-        {
-            leftmostSample = sampleValues.samples->size() - dotsOnScreen;
+    // time distance between sampling points
+    double horizontalFactor = ( sampleValues.interval / scope->horizontal.timebase );
+    // printf( "hF: %g\n", horizontalFactor );
+    unsigned dotsOnScreen = unsigned( ceil( DIVS_TIME / horizontalFactor ) );
+    unsigned preTrigSamples = unsigned( scope->trigger.position * dotsOnScreen );
+    // align displayed trace with trigger mark on screen ...
+    // ... also if trig pos or time/div was changed on a "frozen" or single trace
+    int leftmostPosition = 0;                 // start position on display
+    int leftmostSample = 0;
+    if (dotsOnScreen < sampleValues.samples->size())
+    {
+        leftmostSample = sampleValues.samples->size() - dotsOnScreen;
+    }
+    if(result->triggeredPosition > 0)
+    {
+        leftmostSample = int( result->triggeredPosition );
+        if ( leftmostSample )                     // adjust position if triggered, else start from sample[0]
+            leftmostSample -= preTrigSamples + 1; // shift samples to show a stable trace
+
+        if ( leftmostSample < 0 ) {               // trig pos or time/div was increased
+            leftmostPosition = -leftmostSample;   // trace can't start on left margin
+            leftmostSample = 0;                   // show as much as we have on left side
         }
-        if(result->triggeredPosition > 0)
-        {
-            leftmostSample = int( result->triggeredPosition );
-            if ( leftmostSample )                     // adjust position if triggered, else start from sample[0]
-                leftmostSample -= preTrigSamples + 1; // shift samples to show a stable trace
-
-            if ( leftmostSample < 0 ) {               // trig pos or time/div was increased
-                leftmostPosition = -leftmostSample;   // trace can't start on left margin
-                leftmostSample = 0;                   // show as much as we have on left side
-            }
+    }
+
+    // grid point leftmostSample + 1 is drawn at leftmostPosition, the zoom trace uses the same time axis
+    generateGraphTYzoom( result, channel, horizontalFactor, leftmostSample + 1 - leftmostPosition );
+
+    const unsigned binsPerDiv = 50; // resolution of histogram
+
+    // Set size directly to avoid reallocations (n+1 dots to display n lines)
+    graphVoltage.values.reserve( ++dotsOnScreen * ( interpolationStep ? 2 : 1 ) ); // two dots per "Step"
+    graphHistogram.vertices.reserve( int( 2 * ( binsPerDiv * DIVS_VOLTAGE ) ) );
+
+    const double gain = scope->gain( channel );
+    const double offset = scope->voltage[ channel ].offset;
+
+    const DataChannel *channelData = result->data( channel );
+    if ( !scope->histogram && !channelData->envelopeMin.samples->empty() ) {
+        // more grid points than pixels: two dots per column, its smallest and its largest input value
+        // the values were read from the pyramids of the sample store, a narrow peak is never lost
+        const std::vector< Sample > &minima = *channelData->envelopeMin.samples;
+        const std::vector< Sample > &maxima = *channelData->envelopeMax.samples;
+        const int stride = std::max( int( lround( channelData->envelopeMin.interval / sampleValues.interval ) ), 1 );
+        graphHistogram.clear();
+        // a column starts at grid point column * stride, drawn where the trace below draws that grid point
+        const size_t firstColumn = size_t( ( leftmostSample + stride ) / stride );
+        const int firstPosition = leftmostPosition + int( firstColumn ) * stride - leftmostSample - 1;
+        graphVoltage.setUniform( float( MARGIN_LEFT + firstPosition * horizontalFactor ), float( stride * horizontalFactor ), 2 );
+        graphVoltage.values.reserve( 2 * ( dotsOnScreen / unsigned( stride ) + 2 ) );
+        double previous = 0.0; // y of the last dot, the nearer value of the next column is connected to it
+        for ( size_t column = firstColumn; column < minima.size(); ++column ) {
+            if ( firstPosition + int( column - firstColumn ) * stride >= int( dotsOnScreen ) )
+                break;
+            double low = minima[ column ] / gain + offset;
+            double high = maxima[ column ] / gain + offset;
+            if ( graphVoltage.size() && std::fabs( high - previous ) < std::fabs( low - previous ) )
+                std::swap( low, high );
+            graphVoltage.values.push_back( float( low ) );
+            graphVoltage.values.push_back( float( high ) );
+            previous = high;
         }
+        return;
+    }
 
-        const unsigned binsPerDiv = 50; // resolution of histogram
-
-        // Set size directly to avoid reallocations (n+1 dots to display n lines)
-        graphVoltage.reserve( ++dotsOnScreen * ( interpolationStep ? 2 : 1 ) ); // two dots per "Step"
-        graphHistogram.reserve( int( 2 * ( binsPerDiv * DIVS_VOLTAGE ) ) );
-
-        const double gain = scope->gain( channel );
-        const double offset = scope->voltage[ channel ].offset;
-
-        auto sampleIterator = sampleValues.samples->cbegin() + leftmostSample; // -> visible samples
-        auto sampleEnd = sampleValues.samples->cend() - 1;
-
-        // sinc interpolation if there are too less samples on screen
-        // https://ccrma.stanford.edu/~jos/resample/resample.pdf
-        if ( interpolationSinc && dotsOnScreen < view->screenWidth ) {
-            // we would need sincWidth, but we take what we get
-            const unsigned int left = std::min( sincWidth, unsigned( leftmostSample ) );
-            horizontalFactor /= oversample;                                     // distance between (resampled) dots
-            dotsOnScreen = unsigned( DIVS_TIME / horizontalFactor + 0.99 + 1 ); // dot count after resample
-            const unsigned int resampleSize = ( left + dotsOnScreen + sincWidth ) * oversample;
-            resample.clear();                // invalidate old content
-            resample.resize( resampleSize ); //  ... and init with zero because we accumulate the convolution
-            auto sampleIt = sampleValues.samples->cbegin() + leftmostSample;
-            for ( unsigned int resamplePos = 0; resamplePos < resampleSize; resamplePos += oversample ) {
-                resample[ resamplePos ] += *sampleIt; // sinc( 0 ) sum up, do NOT assign
-                auto sincIt = sinc.cbegin();          // -> one half of sinc pulse without sinc(0)
-                for ( unsigned int sincPos = 1; sincPos <= sincSize; ++sincPos ) {
-                    const double convolute = *sampleIt * *sincIt;
-                    if ( resamplePos >= sincPos ) // left half of sinc in visible range
-                        resample[ resamplePos - sincPos ] += convolute;
-                    if ( resamplePos + sincPos < resampleSize ) // right half of sinc visible
-                        resample[ resamplePos + sincPos ] += convolute;
-                    ++sincIt;
-                }
-                ++sampleIt;
+    auto sampleIterator = sampleValues.samples->cbegin() + leftmostSample; // -> visible samples
+    auto sampleEnd = sampleValues.samples->cend() - 1;
+
+    // sinc interpolation if there are too less samples on screen
+    // https://ccrma.stanford.edu/~jos/resample/resample.pdf
+    if ( interpolationSinc && dotsOnScreen < view->screenWidth ) {
+        // we would need sincWidth, but we take what we get
+        const unsigned int left = std::min( sincWidth, unsigned( leftmostSample ) );
+        horizontalFactor /= oversample;                                     // distance between (resampled) dots
+        dotsOnScreen = unsigned( DIVS_TIME / horizontalFactor + 0.99 + 1 ); // dot count after resample
+        const unsigned int resampleSize = ( left + dotsOnScreen + sincWidth ) * oversample;
+        resample.clear();                // invalidate old content
+        resample.resize( resampleSize ); //  ... and init with zero because we accumulate the convolution
+        auto sampleIt = sampleValues.samples->cbegin() + leftmostSample;
+        for ( unsigned int resamplePos = 0; resamplePos < resampleSize; resamplePos += oversample ) {
+            resample[ resamplePos ] += *sampleIt; // sinc( 0 ) sum up, do NOT assign
+            auto sincIt = sinc.cbegin();          // -> one half of sinc pulse without sinc(0)
+            for ( unsigned int sincPos = 1; sincPos <= sincSize; ++sincPos ) {
+                const double convolute = *sampleIt * *sincIt;
+                if ( resamplePos >= sincPos ) // left half of sinc in visible range
+                    resample[ resamplePos - sincPos ] += convolute;
+                if ( resamplePos + sincPos < resampleSize ) // right half of sinc visible
+                    resample[ resamplePos + sincPos ] += convolute;
+                ++sincIt;
             }
-            leftmostPosition *= oversample;            // scale the position accordingly
-            graphVoltage.reserve( resampleSize );      // provide enough space for resampled dots
-            sampleIterator = resample.cbegin() + left; // now switch from samples -> resamples
-            sampleEnd = resample.cend();               // ... same for end of samples
+            ++sampleIt;
         }
+        leftmostPosition *= oversample;            // scale the position accordingly
+        graphVoltage.values.reserve( resampleSize ); // provide enough space for resampled dots
+        sampleIterator = resample.cbegin() + left; // now switch from samples -> resamples
+        sampleEnd = resample.cend();               // ... same for end of samples
+    }
 
-        graphVoltage.clear();   // remove all previous dots and fill in new trace as GL_LINE_STRIP
-        graphHistogram.clear(); // remove all previous line and fill in new histo as GL_LINES
-        unsigned bins[ int( binsPerDiv * DIVS_VOLTAGE ) ] = { 0 };
-        for ( unsigned int position = unsigned( leftmostPosition ); position < dotsOnScreen && sampleIterator < sampleEnd;
-              ++position ) {
-            double x = double( MARGIN_LEFT + position * horizontalFactor );
-            double y_1 = *sampleIterator++ / gain + offset;
-            double y = *sampleIterator / gain + offset;
-            if ( !scope->histogram ) { // show complete trace
+    // fill in new trace as GL_LINE_STRIP, only the y values, x follows from the position
+    graphVoltage.setUniform( float( MARGIN_LEFT + leftmostPosition * horizontalFactor ), float( horizontalFactor ),
+                             interpolationStep ? 2 : 1 );
+    graphHistogram.clear(); // remove all previous line and fill in new histo as GL_LINES
+    unsigned bins[ int( binsPerDiv * DIVS_VOLTAGE ) ] = { 0 };
+    for ( unsigned int position = unsigned( leftmostPosition ); position < dotsOnScreen && sampleIterator < sampleEnd;
+          ++position ) {
+        double x = double( MARGIN_LEFT + position * horizontalFactor );
+        double y_1 = *sampleIterator++ / gain + offset;
+        double y = *sampleIterator / gain + offset;
+        if ( !scope->histogram ) { // show complete trace
+            if ( interpolationStep )
+                graphVoltage.values.push_back( float( y_1 ) ); // insert horizontal step
+            graphVoltage.values.push_back( float( y ) );
+        } else { // histogram replaces trace in rightmost div
+            int bin = int( round( binsPerDiv * ( y + DIVS_VOLTAGE / 2 ) ) );
+            if ( bin > 0 && bin < binsPerDiv * DIVS_VOLTAGE ) // count value if trace is on screen
+                ++bins[ bin ];
+            if ( x < MARGIN_RIGHT - 1.1 ) { // show trace unless in last div + 10% margin
                 if ( interpolationStep )
-                    graphVoltage.push_back( QVector3D( float( x ), float( y_1 ), 0.0f ) ); // insert horizontal step
-                graphVoltage.push_back( QVector3D( float( x ), float( y ), 0.0f ) );
-            } else { // histogram replaces trace in rightmost div
-                int bin = int( round( binsPerDiv * ( y + DIVS_VOLTAGE / 2 ) ) );
-                if ( bin > 0 && bin < binsPerDiv * DIVS_VOLTAGE ) // count value if trace is on screen
-                    ++bins[ bin ];
-                if ( x < MARGIN_RIGHT - 1.1 ) { // show trace unless in last div + 10% margin
-                    if ( interpolationStep )
-                        graphVoltage.push_back( QVector3D( float( x ), float( y_1 ), 0.0f ) ); // horizontal step
-                    graphVoltage.push_back( QVector3D( float( x ), float( y ), 0.0f ) );
-                }
+                    graphVoltage.values.push_back( float( y_1 ) ); // horizontal step
+                graphVoltage.values.push_back( float( y ) );
             }
         }
+    }
 
-        if ( ( scope->horizontal.format == Dso::GraphFormat::TY ) && scope->histogram ) { // scale and display the histogram
-            double max = 0;                                                               // find max histo count
-            for ( int bin = 0; bin < binsPerDiv * DIVS_VOLTAGE; ++bin ) {
-                if ( bins[ bin ] > max ) {
-                    max = bins[ bin ];
-                }
+    if ( ( scope->horizontal.format == Dso::GraphFormat::TY ) && scope->histogram ) { // scale and display the histogram
+        double max = 0;                                                               // find max histo count
+        for ( int bin = 0; bin < binsPerDiv * DIVS_VOLTAGE; ++bin ) {
+            if ( bins[ bin ] > max ) {
+                max = bins[ bin ];
             }
-            for ( int bin = 0; bin < binsPerDiv * DIVS_VOLTAGE; ++bin ) {
-                if ( bins[ bin ] ) { // show bar (= start and end point) if value exists
-                    double y = double( bin ) / binsPerDiv - DIVS_VOLTAGE / 2 - double( channel ) / binsPerDiv / 2;
-                    // draw a line (as GL_LINES) with from MARGIN_RIGHT to the normalised histo size of this bin
-                    graphHistogram.push_back( QVector3D( float( MARGIN_RIGHT ), float( y ), 0 ) );
-                    graphHistogram.push_back( QVector3D( float( MARGIN_RIGHT - bins[ bin ] / max ), float( y ), 0 ) );
-                }
+        }
+        for ( int bin = 0; bin < binsPerDiv * DIVS_VOLTAGE; ++bin ) {
+            if ( bins[ bin ] ) { // show bar (= start and end point) if value exists
+                double y = double( bin ) / binsPerDiv - DIVS_VOLTAGE / 2 - double( channel ) / binsPerDiv / 2;
+                // draw a line (as GL_LINES) with from MARGIN_RIGHT to the normalised histo size of this bin
+                graphHistogram.vertices.push_back( QVector3D( float( MARGIN_RIGHT ), float( y ), 0 ) );
+                graphHistogram.vertices.push_back( QVector3D( float( MARGIN_RIGHT - bins[ bin ] / max ), float( y ), 0 ) );
             }
         }
     }
 }
 
 
-void GraphGenerator::generateGraphsTYspectrum( PPresult *result ) {
-    if ( scope->verboseLevel > 5 )
-        qDebug() << "     GraphGenerator::generateGraphsTYspectrum()" << result->tag;
-    ready = true;
-    result->vaChannelSpectrum.resize( scope->spectrum.size() );
-    for ( ChannelID channel = 0; channel < scope->voltage.size(); ++channel ) {
-        ChannelGraph &graphSpectrum = result->vaChannelSpectrum[ channel ];
-        const SampleValues &sampleValues = useSpecSamplesOf( channel, result, scope );
-
-        // Check if this channel is used and available at the data analyzer
-        if (!sampleValues.samples || sampleValues.samples->empty() ) {
-            // Delete all vector arrays
-            graphSpectrum.clear();
-            continue;
+void GraphGenerator::generateGraphTYzoom( PPresult *result, ChannelID channel, double horizontalFactor, int marginSample ) {
+    ChannelGraph &graphZoom = result->vaChannelZoom[ channel ];
+    graphZoom.clear();
+    const DataChannel *channelData = result->data( channel );
+    const SampleSnapshot &history = channelData->history;
+    const double left = std::min( scope->getMarker( 0 ), scope->getMarker( 1 ) );
+    const double right = std::max( scope->getMarker( 0 ), scope->getMarker( 1 ) );
+    if ( !view->zoom || history.empty() || right <= left )
+        return;
+
+    // the time axis of the main trace: grid point marginSample at the left margin, horizontalFactor divs per grid point
+    const double gridTime = channelData->voltage.interval * 1e9; // ns
+    const double marginTime = double( channelData->gridStart ) + marginSample * gridTime;
+    const double divTime = gridTime / horizontalFactor;
+    const int64_t begin = int64_t( std::floor( marginTime + ( left - MARGIN_LEFT ) * divTime ) );
+    const int64_t end = int64_t( std::ceil( marginTime + ( right - MARGIN_LEFT ) * divTime ) );
+    const double gain = scope->gain( channel );
+    const double offset = scope->voltage[ channel ].offset;
+
+    // from the sample held at the left marker up to the first one after the right marker
+    const size_t first = std::max( history.after( begin ), size_t( 1 ) ) - 1;
+    const size_t last = std::min( history.after( end ), history.size() - 1 );
+    const size_t columns = std::max( view->screenWidth, 1024u ); // the zoom scope is as wide as the main scope
+    if ( last - first + 1 > columns ) {
+        // more input samples than pixels: the smallest and largest value per column, read from the pyramids
+        std::vector< Sample > &minima = zoomMinima[ channel ];
+        std::vector< Sample > &maxima = zoomMaxima[ channel ];
+        history.envelope( begin, double( end - begin ) / double( columns ), columns, minima, maxima );
+        graphZoom.setUniform( float( left ), float( ( right - left ) / double( columns ) ), 2 );
+        graphZoom.values.reserve( 2 * columns );
+        double previous = 0.0; // y of the last dot, the nearer value of the next column is connected to it
+        for ( size_t column = 0; column < columns; ++column ) {
+            double low = minima[ column ] / gain + offset;
+            double high = maxima[ column ] / gain + offset;
+            if ( column && std::fabs( high - previous ) < std::fabs( low - previous ) )
+                std::swap( low, high );
+            graphZoom.values.push_back( float( low ) );
+            graphZoom.values.push_back( float( high ) );
+            previous = high;
         }
-        // Check if the sample count has changed
-        size_t sampleCount = sampleValues.samples->size();
-        size_t neededSize = sampleCount * 2;
+        return;
+    }
 
-        // Set size directly to avoid reallocations
-        graphSpectrum.reserve( neededSize );
+    // every input sample at its own time, however far the zoom goes
+    const bool interpolationStep = view->interpolation == Dso::INTERPOLATION_STEP;
+    graphZoom.vertices.reserve( ( last - first + 1 ) * ( interpolationStep ? 2 : 1 ) );
+    double previous = 0.0;
+    for ( size_t index = first; index <= last; ++index ) {
+        const float x = float( MARGIN_LEFT + ( double( history.time( index ) ) - marginTime ) / divTime );
+        const double y = history[ index ] / gain + offset;
+        if ( interpolationStep && index > first )
+            graphZoom.vertices.push_back( QVector3D( x, float( previous ), 0.0f ) ); // horizontal step
+        graphZoom.vertices.push_back( QVector3D( x, float( y ), 0.0f ) );
+        previous = y;
+    }
+}
 
-        // What's the horizontal distance between sampling points?
-        double horizontalFactor = sampleValues.interval / scope->horizontal.frequencybase;
 
-        // Fill vector array
-        std::vector< double >::const_iterator dataIterator = sampleValues.samples->begin();
-        const double magnitude = scope->spectrum[ channel ].magnitude;
-        const double offset = scope->spectrum[ channel ].offset;
+void GraphGenerator::generateGraphTYspectrum( PPresult *result, ChannelID channel ) {
+    if ( scope->verboseLevel > 5 )
+        qDebug() << "     GraphGenerator::generateGraphTYspectrum()" << channel << result->tag;
+    ChannelGraph &graphSpectrum = result->vaChannelSpectrum[ channel ];
+    const SampleValues &sampleValues = useSpecSamplesOf( channel, result, scope );
+
+    // Check if this channel is used and available at the data analyzer
+    if (!sampleValues.samples || sampleValues.samples->empty() ) {
+        // Delete all vector arrays
+        graphSpectrum.clear();
+        return;
+    }
+    // Check if the sample count has changed
+    size_t sampleCount = sampleValues.samples->size();
+    size_t neededSize = sampleCount * 2;
 
-        for ( unsigned int position = 0; position < sampleCount; ++position ) {
-            graphSpectrum.push_back( QVector3D( float( position * horizontalFactor - DIVS_TIME / 2 ),
-                                                float( *dataIterator++ / magnitude + offset ), 0.0f ) );
-        }
+    // What's the horizontal distance between sampling points?
+    double horizontalFactor = sampleValues.interval / scope->horizontal.frequencybase;
+
+    // Set size directly to avoid reallocations
+    graphSpectrum.setUniform( float( -DIVS_TIME / 2 ), float( horizontalFactor ) );
+    graphSpectrum.values.reserve( neededSize );
+
+    // Fill vector array
+    std::vector< Sample >::const_iterator dataIterator = sampleValues.samples->begin();
+    const double magnitude = scope->spectrum[ channel ].magnitude;
+    const double offset = scope->spectrum[ channel ].offset;
+
+    for ( unsigned int position = 0; position < sampleCount; ++position ) {
+        graphSpectrum.values.push_back( float( *dataIterator++ / magnitude + offset ) );
     }
 }
 
 
-void GraphGenerator::generateGraphsXY( PPresult *result ) {
+void GraphGenerator::generateGraphXY( PPresult *result, ChannelID channel ) {
     if ( scope->verboseLevel > 5 )
-        qDebug() << "     GraphGenerator::generateGraphsXY()" << result->tag;
-    result->vaChannelVoltage.resize( scope->voltage.size() );
-
-    // Delete all spectrum graphs
-    for ( ChannelGraph &data : result->vaChannelSpectrum )
-        data.clear();
-
-    // Generate voltage graphs for pairs of channels
-    for ( ChannelID channel = 0; channel < scope->voltage.size(); channel += 2 ) {
-        // We need pairs of channels.
-        if ( channel + 1 == scope->voltage.size() ) {
-            result->vaChannelVoltage[ channel ].clear();
-            continue;
-        }
+        qDebug() << "     GraphGenerator::generateGraphXY()" << channel << result->tag;
+    // We need pairs of channels.
+    if ( channel + 1 == scope->voltage.size() ) {
+        result->vaChannelVoltage[ channel ].clear();
+        return;
+    }
 
-        const ChannelID xChannel = channel;
-        const ChannelID yChannel = channel + 1;
+    const ChannelID xChannel = channel;
+    const ChannelID yChannel = channel + 1;
 
-        const SampleValues &xSamples = useVoltSamplesOf( xChannel, result, scope );
-        const SampleValues &ySamples = useVoltSamplesOf( yChannel, result, scope );
+    const SampleValues &xSamples = useVoltSamplesOf( xChannel, result, scope );
+    const SampleValues &ySamples = useVoltSamplesOf( yChannel, result, scope );
 
-        // The channels need to be active
-        if ( !xSamples.samples->size() || !ySamples.samples->size() ) {
-            result->vaChannelVoltage[ xChannel ].clear();
-            result->vaChannelVoltage[ yChannel ].clear();
-            continue;
-        }
+    // The channels need to be active
+    if ( !xSamples.samples->size() || !ySamples.samples->size() ) {
+        result->vaChannelVoltage[ xChannel ].clear();
+        result->vaChannelVoltage[ yChannel ].clear();
+        return;
+    }
 
-        // Check if the sample count has changed
-        const size_t sampleCount = std::min( xSamples.samples->size(), ySamples.samples->size() );
-        ChannelGraph &graphXY = result->vaChannelVoltage[ yChannel ]; // color of y channel
-        graphXY.reserve( sampleCount * 2 );
-
-        // Fill vector array
-        std::vector< double >::const_iterator xIterator = xSamples.samples->begin();
-        std::vector< double >::const_iterator yIterator = ySamples.samples->begin();
-        const double xGain = scope->gain( xChannel );
-        const double yGain = scope->gain( yChannel );
-        const double xOffset = ( scope->trigger.position - 0.5 ) * DIVS_TIME;
-        const double yOffset = scope->voltage[ yChannel ].offset;
-
-        for ( unsigned int position = 0; position < sampleCount; ++position ) {
-            graphXY.push_back( QVector3D( float( *xIterator++ / xGain + xOffset ), float( *yIterator++ / yGain + yOffset ), 0.0 ) );
-        }
+    // Check if the sample count has changed
+    const size_t sampleCount = std::min( xSamples.samples->size(), ySamples.samples->size() );
+    ChannelGraph &graphXY = result->vaChannelVoltage[ yChannel ]; // color of y channel
+    graphXY.vertices.reserve( sampleCount * 2 );
+
+    // Fill vector array
+    std::vector< Sample >::const_iterator xIterator = xSamples.samples->begin();
+    std::vector< Sample >::const_iterator yIterator = ySamples.samples->begin();
+    const double xGain = scope->gain( xChannel );
+    const double yGain = scope->gain( yChannel );
+    const double xOffset = ( scope->trigger.position - 0.5 ) * DIVS_TIME;
+    const double yOffset = scope->voltage[ yChannel ].offset;
+
+    for ( unsigned int position = 0; position < sampleCount; ++position ) {
+        graphXY.vertices.push_back(
+            QVector3D( float( *xIterator++ / xGain + xOffset ), float( *yIterator++ / yGain + yOffset ), 0.0 ) );
     }
 }
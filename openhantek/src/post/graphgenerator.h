@@ -18,29 +18,41 @@ namespace Dso {
 struct ControlSpecification;
 }
 
-/// \brief Generates ready to be used vertex arrays
+/// \brief Generates ready to be used vertex arrays, one task per channel.
 class GraphGenerator : public QObject, public Processor {
     Q_OBJECT
 
   public:
     GraphGenerator( const DsoSettingsScope *scope, const DsoSettingsView *view );
 
+    // Processor interface
+    Products inputs() const override { return Samples | Spectrum; }
+    const char *name() const override { return "graph"; }
+    Products outputs() const override { return VoltageGraph | SpectrumGraph | Histogram; }
+    bool perChannel() const override { return true; }
+    void prepare( PPresult *result ) override;
+    void processChannel( PPresult *result, ChannelID channel ) override;
+
   private:
-    void generateGraphsTYvoltage( PPresult *result );
-    void generateGraphsTYspectrum( PPresult *result );
-    void generateGraphsXY( PPresult *result );
+    void generateGraphTYvoltage( PPresult *result, ChannelID channel );
+    /// \brief The voltage trace between the markers for the zoom scope, taken from the input samples at the
+    /// resolution of the zoom scope: every sample if there are fewer samples than pixels, else min/max columns.
+    /// \param marginSample Grid point of the voltage samples at the left margin of the main trace.
+    void generateGraphTYzoom( PPresult *result, ChannelID channel, double horizontalFactor, int marginSample );
+    void generateGraphTYspectrum( PPresult *result, ChannelID channel );
+    /// \brief The graph of the pair `channel` (x, even) and `channel` + 1 (y).
+    void generateGraphXY( PPresult *result, ChannelID channel );
 
     bool ready = false;
     const DsoSettingsScope *scope;
     const DsoSettingsView *view;
 
     void prepareSinc( void );                             // setup the sinc table used for upsampling
-    std::vector< double > sinc;                           // sinc function table for convolution
+    std::vector< Sample > sinc;                           // sinc function table for convolution
     const unsigned int sincWidth = 2;                     // two periods
     const unsigned int oversample = 5;                    // 5 time oversample
     const unsigned int sincSize = sincWidth * oversample; // size of the table
-    std::vector< double > resample;                       // destination for overampled data
-
-    // Processor interface
-    void process( PPresult *data ) override;
+    std::vector< std::vector< Sample > > resample;        // per channel destination for overampled data
+    std::vector< std::vector< Sample > > zoomMinima;      // per channel min/max columns of the zoom trace
+    std::vector< std::vector< Sample > > zoomMaxima;
 };
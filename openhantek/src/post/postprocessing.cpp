@@ -2,13 +2,20 @@
 
 #include "postprocessing.h"
 
+#include <cmath>
+
 PostProcessing::PostProcessing( ChannelID channelCount, int verboseLevel )
-    : channelCount( channelCount ), verboseLevel( verboseLevel ) {
+    : channelCount( channelCount ), pool( channelCount, verboseLevel ), scheduler( 0, verboseLevel ),
+      handoverStage( FrameTrace::instance().stage( "handover" ) ), resampleStage( FrameTrace::instance().stage( "resample" ) ),
+      processStage( FrameTrace::instance().stage( "post processing" ) ), verboseLevel( verboseLevel ) {
     qRegisterMetaType< std::shared_ptr< PPresult > >();
 }
 
 
-void PostProcessing::registerProcessor( Processor *processor ) { processors.push_back( processor ); }
+void PostProcessing::registerProcessor( Processor *processor ) {
+    processors.push_back( processor );
+    scheduler.setProcessors( processors );
+}
 
 
 // static
@@ -28,19 +35,34 @@ void PostProcessing::convertData( const DSOsamples *source, PPresult *destinatio
     }
 
     for ( ChannelID channel = 0; channel < source->data.size(); ++channel ) {
-        std::vector< double >* rawChannelData = source->data.at( channel );
+        const SampleSnapshot &rawChannelData = source->data.at( channel );
 
-        if (!rawChannelData || rawChannelData->empty() ) {
+        if ( rawChannelData.empty() || channel >= destination->channelCount() ) {
             continue;
         }
         DataChannel *const channelData = destination->modifiableData( channel );
         channelData->voltage.interval = 1.0 / source->samplerate;
-        channelData->voltage.samples = rawChannelData;
+        // DsoInput aligns the start to the grid, a sample keeps its index while the frames roll on
+        channelData->gridOrigin = std::llround( double( source->startTime.at( channel ) ) * source->samplerate / 1e9 );
+        channelData->gridStart = source->startTime.at( channel );
+        channelData->history = rawChannelData; // shares the blocks, the zoom trace is taken from them
+        // time stamped input samples -> uniform grid for the graph and the spectrum, the only pass over the values
+        rawChannelData.resample( source->startTime.at( channel ), 1e9 / source->samplerate, source->sampleCount,
+                                 channelData->voltage.samples.modify() );
+        if ( source->envelopeStride > 1 ) { // the peaks between the grid points for the graph, from the pyramids
+            const size_t stride = source->envelopeStride;
+            const double interval = double( stride ) / source->samplerate;
+            channelData->envelopeMin.interval = channelData->envelopeMax.interval = interval;
+            const size_t columns = ( source->sampleCount + stride - 1 ) / stride;
+            rawChannelData.envelope( source->startTime.at( channel ), interval * 1e9, columns,
+                                     channelData->envelopeMin.samples.modify(), channelData->envelopeMax.samples.modify() );
+        }
         // printf( "PP CH%d: %d\n", channel+1, source->clipped );
         channelData->valid = !( source->clipped & ( 0x01 << channel ) );
     }
     //destination->modifiableData( 2 )->voltageUnit = source->mathVoltageUnit; // MATH channel unit
     destination->tag = source->tag;
+    destination->stamps = source->stamps;
 }
 
 
@@ -48,11 +70,47 @@ void PostProcessing::input( const DSOsamples *data ) {
     if ( data && processing ) {
         if ( verboseLevel > 4 )
             qDebug() << "    PostProcessing::input()" << data->tag;
-        currentData.reset( new PPresult( channelCount ) ); // start with a fresh data structure
-        convertData( data, currentData.get() );            // copy all relevant data over
-        for ( Processor *p : processors )                  // feed it into the PP chain
-            p->process( currentData.get() );
+        FrameTrace &trace = FrameTrace::instance();
+        const int64_t start = FrameTrace::now();
+        trace.span( handoverStage, data->stamps.built, start, data->tag ); // waited in the mailbox
+        // shared from the start, a processor (e.g. the raw sample export) may keep a reference to it
+        currentData = pool.acquire(); // a released frame, cleared but with the capacity of all its arrays
+        convertData( data, currentData.get() );                     // resample the input snapshots
+        const int64_t resampled = FrameTrace::now();
+        trace.span( resampleStage, start, resampled, data->tag );
+        scheduler.run( currentData.get() );                         // feed it into the PP graph
+        currentData->stamps.processed = FrameTrace::now();
+        trace.span( processStage, resampled, currentData->stamps.processed, data->tag );
         std::shared_ptr< PPresult > res = std::move( currentData );
+        if ( paced )
+            displayBusy = true;
         emit processingFinished( res );
     }
 }
+
+
+void PostProcessing::receive() {
+    if ( !mailbox )
+        return;
+    while ( !displayBusy ) {
+        const DSOsamples *frame = mailbox->take();
+        if ( !frame )
+            break;
+        input( frame );
+    }
+    if ( verboseLevel > 1 ) { // the display lags the input if frames are lost
+        const FrameMailbox::Statistics statistics = mailbox->statistics();
+        if ( statistics.coalesced != reported.coalesced || statistics.dropped != reported.dropped ) {
+            qDebug() << " PostProcessing::receive()" << statistics.delivered << "of" << statistics.posted << "frames,"
+                     << statistics.coalesced - reported.coalesced << "coalesced," << statistics.dropped - reported.dropped
+                     << "dropped";
+            reported = statistics;
+        }
+    }
+}
+
+
+void PostProcessing::frameShown() {
+    displayBusy = false;
+    receive();
+}
@@ -3,7 +3,10 @@
 #pragma once
 
 #include "dsosamples.h"
+#include "input/framemailbox.h"
 #include "processor.h"
+#include "ppresultpool.h"
+#include "processorscheduler.h"
 
 #include <memory>
 #include <vector>
@@ -15,7 +18,8 @@
 
 /**
  * Manages all post processing processors. Register another processor with `registerProcessor(p)`.
- * All processors, in the order of insertion, will process the input data, given by `input(data)`.
+ * All processors will process the input data, given by `input(data)`, in the order of insertion where they
+ * depend on each other and concurrently otherwise (see ProcessorScheduler).
  * The final result will be made available via the `processingFinished` signal.
  */
 class PostProcessing : public QObject {
@@ -31,17 +35,33 @@ class PostProcessing : public QObject {
      */
     void registerProcessor( Processor *processor );
     void stop() { processing = false; }
+    /// \brief Take the frames from `mailbox` when receive() is called. This class does not take ownership.
+    void setMailbox( FrameMailbox *mailbox ) { this->mailbox = mailbox; }
+    /// \brief Finish the next frame only after the display has taken the last one (frameShown()), the frames in
+    /// between stay coalesced in the mailbox (see RenderScheduler).
+    void setPaced( bool paced ) { this->paced = paced; }
 
 
   private:
-    /// A new `PPresult` is created for each new input. We need to know the channel size.
+    /// A `PPresult` is taken from the pool for each new input. We need to know the channel size.
     const unsigned channelCount;
+    /// The frames released by all consumers, reused with the capacity of their arrays
+    PPresultPool pool;
     /// The list of processors. Processors are not memory managed by this class.
     std::vector< Processor * > processors;
+    /// Runs the independent (processor, channel) tasks of a frame in parallel
+    ProcessorScheduler scheduler;
+    unsigned handoverStage; ///< FrameTrace stages of input()
+    unsigned resampleStage;
+    unsigned processStage;
     ///
-    std::unique_ptr< PPresult > currentData;
+    std::shared_ptr< PPresult > currentData;
     static void convertData( const DSOsamples *source, PPresult *destination );
+    FrameMailbox *mailbox = nullptr;
+    FrameMailbox::Statistics reported; ///< Counters of the mailbox at the last report of lost frames
     bool processing = true;
+    bool paced = false;
+    bool displayBusy = false; ///< Paced: a finished frame was not yet taken by the display
     int verboseLevel = 0;
 
   public slots:
@@ -51,6 +71,10 @@ class PostProcessing : public QObject {
      * @param data
      */
     void input( const DSOsamples *data );
+    /// \brief Process the pending frames of the mailbox, only the newest one unless it has more slots.
+    void receive();
+    /// \brief The display has taken the last finished frame, process the newest pending one.
+    void frameShown();
 
   signals:
     void processingFinished( std::shared_ptr< PPresult > result );
@@ -3,8 +3,67 @@
 #include "ppresult.h"
 #include <QDebug>
 
+std::vector< Sample > &SharedSamples::modify() {
+    if ( !values )
+        values = std::make_shared< std::vector< Sample > >();
+    else if ( values.use_count() > 1 ) // another result still reads them
+        values = std::make_shared< std::vector< Sample > >( *values );
+    return *values;
+}
+
+
+void SharedSamples::clear() {
+    if ( values && values.use_count() == 1 )
+        values->clear();
+    else
+        values.reset();
+}
+
+
+// static
+const std::vector< Sample > &SharedSamples::emptyValues() {
+    static const std::vector< Sample > empty;
+    return empty;
+}
+
+
 PPresult::PPresult( unsigned int channelCount ) { analyzedData.resize( channelCount ); }
 
+
+void PPresult::recycle() {
+    softwareTriggerTriggered = false;
+    triggeredPosition = 0;
+    pulseWidth1 = 0.0;
+    pulseWidth2 = 0.0;
+    tag = 0;
+    stamps = FrameStamps();
+    rolling = false;
+    // assigning a default DataChannel would allocate a new note string, reset the members one by one
+    for ( DataChannel &channel : analyzedData ) {
+        channel.voltage.samples.clear();
+        channel.voltage.interval = 0.0;
+        channel.spectrum.samples.clear();
+        channel.spectrum.interval = 0.0;
+        channel.envelopeMin.samples.clear();
+        channel.envelopeMax.samples.clear();
+        channel.envelopeMin.interval = channel.envelopeMax.interval = 0.0;
+        channel.gridOrigin = 0;
+        channel.gridStart = 0;
+        channel.history.clear();
+        channel.valid = true;
+        channel.vmin = channel.vmax = channel.rms = 0.0;
+        channel.dBmin = channel.dBmax = 0.0;
+        channel.dc = channel.ac = channel.dB = 0.0;
+        channel.frequency = channel.thd = 0.0;
+        channel.note.clear();
+        channel.pulseWidth1 = channel.pulseWidth2 = 0.0;
+        channel.voltageUnit = UNIT_VOLTS;
+    }
+    for ( ChannelsGraphs *graphs : { &vaChannelSpectrum, &vaChannelVoltage, &vaChannelHistogram, &vaChannelZoom } )
+        for ( ChannelGraph &graph : *graphs )
+            graph.clear();
+}
+
 const DataChannel *PPresult::data( ChannelID channel ) const {
     if ( channel >= analyzedData.size() )
         return nullptr;
@@ -6,19 +6,49 @@
 #include <QVector3D>
 
 #include "hantekprotocol/types.h"
+#include "input/samplestore.h"
+#include "input/sampletype.h"
+#include "utils/frametrace.h"
 #include "utils/printutils.h"
+#include <memory>
 #include <vector>
 
+/// \brief Reference counted sample values with copy-on-write.
+///
+/// The values are written once by the processor that creates them and are read-only afterwards.
+/// Copies share the values, so a result can be handed to the graph generator, the exporters and
+/// both scopes without copying any sample. A writer that finds the values shared detaches first.
+class SharedSamples {
+  public:
+    const std::vector< Sample > &operator*() const { return values ? *values : emptyValues(); }
+    const std::vector< Sample > *operator->() const { return &**this; }
+    explicit operator bool() const { return bool( values ); }
+
+    /// \brief The values for writing, copied first if they are shared with another owner.
+    std::vector< Sample > &modify();
+    /// \brief Empty the values, their memory is kept for the next frame unless another owner still reads them.
+    void clear();
+
+  private:
+    static const std::vector< Sample > &emptyValues();
+    std::shared_ptr< std::vector< Sample > > values;
+};
+
 /// \brief Struct for a array of sample values.
 struct SampleValues {
-    std::vector< double >* samples; ///< Vector holding the sampling data
-    double interval = 0.0;         ///< The interval between two sample values
+    SharedSamples samples; ///< The sampling data, shared by all copies of the result
+    double interval = 0.0; ///< The interval between two sample values
 };
 
 /// \brief Struct for the analyzed data.
 struct DataChannel {
     SampleValues voltage;          ///< The time-domain voltage levels (V)
     SampleValues spectrum;         ///< The frequency-domain power levels (dB)
+    SampleValues envelopeMin;      ///< The smallest input value per column of voltage samples, empty if not decimated
+    SampleValues envelopeMax;      ///< The largest input value per column of voltage samples
+    int64_t gridOrigin = 0;        ///< Index of the first voltage sample on the time grid (start time / interval)
+    int64_t gridStart = 0;         ///< Time (ns) of the first voltage sample
+    SampleSnapshot history;        ///< The time stamped input samples of the frame, for other resolutions (zoom)
     bool valid = true;             ///< Not clipped, distorted, dropouts etc.
     double vmin = 0.0;             ///< The minimum sample value of _displayed_ part of trace
     double vmax = 0.0;             ///< The maximum sample value of _displayed_ part of trace
@@ -36,14 +66,43 @@ struct DataChannel {
     Unit voltageUnit = UNIT_VOLTS; ///< unless UNIT_VOLTSQUARE for some math functions
 };
 
-typedef std::vector< QVector3D > ChannelGraph;
+/// \brief The vertices of one trace.
+/// A trace on a uniform x grid stores only the y of its vertices (`values`), vertex i is at
+/// x = `x0` + ( i / `repeat` ) * `dx` and the vertex shader of GlScope computes this x from the vertex index.
+/// The other traces (histogram, XY) store free vertices (x, y, 0).
+struct ChannelGraph {
+    std::vector< QVector3D > vertices; ///< Free vertices
+    std::vector< float > values;       ///< y of the vertices of a uniform trace
+    float x0 = 0.0f;                   ///< x of the first uniform vertex
+    float dx = 0.0f;                   ///< x distance of two uniform vertices
+    unsigned repeat = 1;               ///< Vertices per x position, 2 for steps and min/max columns
+
+    /// \brief Start a uniform trace, the values are cleared but keep their capacity.
+    void setUniform( float x0, float dx, unsigned repeat = 1 ) {
+        values.clear();
+        this->x0 = x0;
+        this->dx = dx;
+        this->repeat = repeat;
+    }
+    /// \brief x of uniform vertex `index`.
+    float x( size_t index ) const { return x0 + float( index / repeat ) * dx; }
+    size_t size() const { return vertices.size() + values.size(); }
+    bool empty() const { return vertices.empty() && values.empty(); }
+    void clear() {
+        vertices.clear();
+        values.clear();
+    }
+};
 typedef std::vector< ChannelGraph > ChannelsGraphs;
 
-/// Post processing results
-class PPresult {
+/// Post processing results, shared by its consumers (std::shared_ptr) and not changed after it was published
+class PPresult : public std::enable_shared_from_this< PPresult > {
   public:
     explicit PPresult( unsigned int channelCount );
 
+    /// \brief Reset all values for the next frame, the vectors keep their capacity (see PPresultPool).
+    void recycle();
+
     /// \brief Returns the analyzed data (RO).
     /// \param channel Channel, whose data should be returned.
     const DataChannel *data( ChannelID channel ) const;
@@ -61,10 +120,13 @@ class PPresult {
     double pulseWidth1 = 0.0;  ///< The width of the triggered pulse
     double pulseWidth2 = 0.0;  ///< The width of the following pulse
     unsigned tag;              ///< track individual sample blocks (debug support)
+    FrameStamps stamps;        ///< Times of the frame in the input and the post processing
+    bool rolling = false;      ///< Roll mode without voltage graphs, the scopes append the new samples (see RollGraph)
 
     ChannelsGraphs vaChannelSpectrum;
     ChannelsGraphs vaChannelVoltage;
     ChannelsGraphs vaChannelHistogram;
+    ChannelsGraphs vaChannelZoom; ///< Voltage traces between the markers at the resolution of the zoom scope
 
   private:
     std::vector< DataChannel > analyzedData; ///< The analyzed data for each channel
@@ -0,0 +1,29 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <atomic>
+
+#include <QDebug>
+
+#include "ppresultpool.h"
+
+
+PPresultPool::PPresultPool( unsigned channelCount, int verboseLevel )
+    : channelCount( channelCount ), verboseLevel( verboseLevel ) {}
+
+
+std::shared_ptr< PPresult > PPresultPool::acquire() {
+    for ( size_t checked = 0; checked < frames.size(); ++checked ) {
+        std::shared_ptr< PPresult > &frame = frames[ next ];
+        next = ( next + 1 ) % frames.size();
+        // nobody else can take a new reference to a frame that only the pool holds
+        if ( frame.use_count() == 1 ) {
+            std::atomic_thread_fence( std::memory_order_acquire ); // see all accesses of the last consumer
+            frame->recycle();
+            return frame;
+        }
+    }
+    frames.push_back( std::make_shared< PPresult >( channelCount ) );
+    if ( verboseLevel > 2 )
+        qDebug() << "  PPresultPool::acquire()" << frames.size() << "frames";
+    return frames.back();
+}
@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "ppresult.h"
+
+
+/// \brief Recycles the processed frames with their sample and vertex arrays.
+///
+/// The pool keeps a reference to every frame it has created. A frame that is referenced by the pool only
+/// has been released by all consumers (scopes, exporters, queued signals) and is handed out again, cleared
+/// but with the capacity of all its vectors, so a steady stream of frames allocates nothing.
+/// A new frame is created only while all others are still in use. Used by the post processing thread only.
+class PPresultPool {
+  public:
+    explicit PPresultPool( unsigned channelCount, int verboseLevel = 0 );
+
+    /// \brief A released frame or a new one if there is none.
+    std::shared_ptr< PPresult > acquire();
+    /// \brief Number of frames created so far, i.e. the most frames in use at the same time.
+    size_t size() const { return frames.size(); }
+
+  private:
+    const unsigned channelCount;
+    std::vector< std::shared_ptr< PPresult > > frames;
+    size_t next = 0; ///< Search start, the frames are reused round robin, the oldest one first
+    int verboseLevel = 0;
+};
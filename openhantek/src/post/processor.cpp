@@ -3,3 +3,10 @@
 #include "processor.h"
 
 Processor::~Processor() {}
+
+
+void Processor::process( PPresult *result ) {
+    prepare( result );
+    for ( ChannelID channel = 0; channel < result->channelCount(); ++channel )
+        processChannel( result, channel );
+}
@@ -4,8 +4,40 @@
 
 #include "ppresult.h"
 
+/// \brief A step of the post processing.
+///
+/// A processor declares the parts of the frame it reads and writes, the ProcessorScheduler runs the
+/// processors that do not depend on each other concurrently. A processor that works on each channel on its
+/// own is split into one task per channel, its processChannel() is then called concurrently for different
+/// channels of the same frame. The defaults describe a processor that reads and writes everything on one thread.
 class Processor {
   public:
+    /// \brief Parts of a PPresult, a processor that reads a product runs after the processors that write it.
+    enum Product : unsigned {
+        Samples = 1 << 0,       ///< DataChannel::voltage, the resampled input
+        Spectrum = 1 << 1,      ///< DataChannel::spectrum and the measured values of a channel
+        VoltageGraph = 1 << 2,  ///< PPresult::vaChannelVoltage and vaChannelZoom
+        SpectrumGraph = 1 << 3, ///< PPresult::vaChannelSpectrum
+        Histogram = 1 << 4,     ///< PPresult::vaChannelHistogram
+        ExportTap = 1 << 5,     ///< The frame handed to the exporters
+        AllProducts = ~0u
+    };
+    typedef unsigned Products;
+
     virtual ~Processor();
-    virtual void process( PPresult * ) = 0;
+    /// \brief Stage name of the processor in the FrameTrace, a string literal.
+    virtual const char *name() const { return "processor"; }
+    /// \brief Process the complete frame on the calling thread.
+    /// A processor with channel tasks calls prepare() and then processChannel() for every channel.
+    virtual void process( PPresult * );
+
+    virtual Products inputs() const { return AllProducts; }
+    virtual Products outputs() const { return AllProducts; }
+
+    /// \brief If true, prepare() runs once per frame and then processChannel() once per channel, the channels
+    /// concurrently. Per channel state of the processor must not be shared between the channels then.
+    virtual bool perChannel() const { return false; }
+    /// \brief Frame wide work before the channel tasks, e.g. sizing the output vectors. It touches the outputs only.
+    virtual void prepare( PPresult * ) {}
+    virtual void processChannel( PPresult *, ChannelID ) {}
 };
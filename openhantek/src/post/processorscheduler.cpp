@@ -0,0 +1,191 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <algorithm>
+
+#include <QDebug>
+#include <QThread>
+
+#include "processorscheduler.h"
+
+
+ProcessorScheduler::ProcessorScheduler( unsigned threads, int verboseLevel ) : verboseLevel( verboseLevel ) {
+    if ( threads == 0 )
+        threads = std::max( std::thread::hardware_concurrency(), 1u );
+    for ( unsigned worker = 0; worker < threads; ++worker )
+        queues.emplace_back( new Queue() );
+    for ( unsigned worker = 1; worker < threads; ++worker )
+        this->threads.emplace_back( [ this, worker ]() { work( worker ); } );
+    if ( verboseLevel > 1 )
+        qDebug() << " ProcessorScheduler::ProcessorScheduler()" << threads << "threads";
+}
+
+
+ProcessorScheduler::~ProcessorScheduler() {
+    {
+        std::lock_guard< std::mutex > lock( wakeMutex );
+        quit = true;
+    }
+    wake.notify_all();
+    for ( std::thread &thread : threads )
+        thread.join();
+}
+
+
+void ProcessorScheduler::setProcessors( const std::vector< Processor * > &processors ) {
+    this->processors = processors;
+    built = false;
+}
+
+
+void ProcessorScheduler::build( unsigned channelCount ) {
+    tasks.clear();
+    roots.clear();
+    const auto addTask = [ this ]( Processor *processor, int channel ) {
+        tasks.emplace_back( new Task() );
+        tasks.back()->processor = processor;
+        tasks.back()->channel = channel;
+        tasks.back()->stage = FrameTrace::instance().stage( processor->name() );
+        return unsigned( tasks.size() - 1 );
+    };
+    const auto link = [ this ]( unsigned from, unsigned to ) {
+        tasks[ from ]->successors.push_back( to );
+        ++tasks[ to ]->dependencies;
+    };
+    std::vector< unsigned > entry( processors.size() );        // prepare() or process() of a processor
+    std::vector< unsigned > firstChannel( processors.size() ); // its channel tasks follow in channel order
+    std::vector< unsigned > channels( processors.size() );     // number of its channel tasks
+    for ( size_t index = 0; index < processors.size(); ++index ) {
+        Processor *processor = processors[ index ];
+        entry[ index ] = addTask( processor, -1 );
+        firstChannel[ index ] = unsigned( tasks.size() );
+        channels[ index ] = processor->perChannel() ? channelCount : 0;
+        for ( unsigned channel = 0; channel < channels[ index ]; ++channel )
+            link( entry[ index ], addTask( processor, int( channel ) ) );
+
+        for ( size_t earlier = 0; earlier < index; ++earlier ) {
+            const Processor *other = processors[ earlier ];
+            const bool overwrites = processor->outputs() & ( other->inputs() | other->outputs() );
+            const bool reads = processor->inputs() & other->outputs();
+            if ( !overwrites && !reads )
+                continue; // independent, both run concurrently
+            if ( !overwrites && channels[ index ] && channels[ earlier ] ) { // channel by channel
+                link( entry[ earlier ], entry[ index ] );
+                for ( unsigned channel = 0; channel < channelCount; ++channel )
+                    link( firstChannel[ earlier ] + channel, firstChannel[ index ] + channel );
+            } else if ( channels[ earlier ] ) { // after all channels of the earlier one
+                for ( unsigned channel = 0; channel < channels[ earlier ]; ++channel )
+                    link( firstChannel[ earlier ] + channel, entry[ index ] );
+            } else
+                link( entry[ earlier ], entry[ index ] );
+        }
+    }
+    for ( unsigned task = 0; task < tasks.size(); ++task )
+        if ( !tasks[ task ]->dependencies )
+            roots.push_back( task );
+    for ( std::unique_ptr< Queue > &queue : queues ) {
+        queue->ring.assign( tasks.size(), 0 );
+        queue->head = queue->count = 0;
+    }
+    builtChannels = channelCount;
+    built = true;
+    if ( verboseLevel > 2 )
+        qDebug() << "  ProcessorScheduler::build()" << processors.size() << "processors," << channelCount << "channels,"
+                 << tasks.size() << "tasks," << roots.size() << "roots";
+}
+
+
+void ProcessorScheduler::run( PPresult *result ) {
+    if ( !built || builtChannels != result->channelCount() )
+        build( result->channelCount() );
+    if ( tasks.empty() )
+        return;
+    for ( std::unique_ptr< Task > &task : tasks )
+        task->remaining.store( task->dependencies, std::memory_order_relaxed );
+    current = result;
+    unfinished.store( unsigned( tasks.size() ) );
+    for ( unsigned task : roots )
+        push( 0, task );
+
+    unsigned task = 0;
+    std::unique_lock< std::mutex > lock( wakeMutex );
+    while ( unfinished.load() > 0 ) {
+        lock.unlock();
+        while ( take( 0, task ) )
+            execute( task, 0 );
+        lock.lock();
+        wake.wait( lock, [ this ]() { return unfinished.load() == 0 || queued.load() > 0; } );
+    }
+    current = nullptr;
+}
+
+
+void ProcessorScheduler::execute( unsigned index, unsigned worker ) {
+    Task &task = *tasks[ index ];
+    const int64_t begin = FrameTrace::now();
+    if ( task.channel >= 0 )
+        task.processor->processChannel( current, ChannelID( task.channel ) );
+    else if ( task.processor->perChannel() )
+        task.processor->prepare( current );
+    else
+        task.processor->process( current );
+    FrameTrace::instance().span( task.stage, begin, FrameTrace::now(), current->tag, task.channel );
+    for ( unsigned successor : task.successors ) // the last finished dependency queues the successor
+        if ( tasks[ successor ]->remaining.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+            push( worker, successor );
+    if ( unfinished.fetch_sub( 1 ) == 1 ) { // wake run()
+        std::lock_guard< std::mutex > lock( wakeMutex );
+        wake.notify_all();
+    }
+}
+
+
+void ProcessorScheduler::push( unsigned worker, unsigned task ) {
+    {
+        Queue &queue = *queues[ worker ];
+        std::lock_guard< std::mutex > lock( queue.mutex );
+        queue.ring[ ( queue.head + queue.count++ ) % queue.ring.size() ] = task;
+    }
+    queued.fetch_add( 1 );
+    {
+        std::lock_guard< std::mutex > lock( wakeMutex ); // no lost wake up between the check and the wait
+    }
+    wake.notify_one();
+}
+
+
+bool ProcessorScheduler::take( unsigned worker, unsigned &task ) {
+    if ( queued.load() == 0 )
+        return false;
+    for ( size_t offset = 0; offset < queues.size(); ++offset ) {
+        Queue &queue = *queues[ ( worker + offset ) % queues.size() ];
+        std::lock_guard< std::mutex > lock( queue.mutex );
+        if ( !queue.count )
+            continue;
+        if ( offset == 0 ) { // own queue, the newest task is still hot in the cache
+            task = queue.ring[ ( queue.head + --queue.count ) % queue.ring.size() ];
+        } else { // steal the oldest one
+            task = queue.ring[ queue.head ];
+            queue.head = ( queue.head + 1 ) % queue.ring.size();
+            --queue.count;
+        }
+        queued.fetch_sub( 1 );
+        return true;
+    }
+    return false;
+}
+
+
+void ProcessorScheduler::work( unsigned worker ) {
+    QThread::currentThread()->setObjectName( QString( "post processing %1" ).arg( worker ) ); // names the trace
+    std::unique_lock< std::mutex > lock( wakeMutex );
+    for ( ;; ) {
+        wake.wait( lock, [ this ]() { return quit || queued.load() > 0; } );
+        if ( quit )
+            return;
+        lock.unlock();
+        unsigned task = 0;
+        while ( take( worker, task ) )
+            execute( task, worker );
+        lock.lock();
+    }
+}
@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "processor.h"
+
+
+/// \brief Runs the processors of a frame as a dependency graph on a work-stealing thread pool.
+///
+/// Every processor is a task, a processor with channel tasks (Processor::perChannel()) is split into its
+/// prepare() task and one task per channel. A processor runs after the earlier registered processors whose
+/// outputs it reads or whose inputs or outputs it writes. If both have channel tasks and it only reads their
+/// outputs, a channel waits for the same channel of the other processor only, so e.g. the graph of channel 3
+/// is built while channel 7 is still resampled.
+/// Each worker pushes the tasks it makes ready to the back of its own queue and takes them from there, an idle
+/// worker steals from the front of the other queues. The thread that calls run() is worker 0 and returns when
+/// the frame is complete.
+class ProcessorScheduler {
+  public:
+    /// \param threads Workers including the calling thread, 0 for one per core.
+    explicit ProcessorScheduler( unsigned threads = 0, int verboseLevel = 0 );
+    /// \brief Stops and joins the workers.
+    ~ProcessorScheduler();
+
+    /// \brief Use `processors` in this order of registration for the following frames.
+    void setProcessors( const std::vector< Processor * > &processors );
+    /// \brief Process `result` with all processors, blocks until all tasks are done.
+    void run( PPresult *result );
+    unsigned threadCount() const { return unsigned( queues.size() ); }
+
+  private:
+    struct Task {
+        Processor *processor = nullptr;
+        int channel = -1;                    ///< -1: prepare() or process() of the complete frame
+        unsigned stage = 0;                  ///< FrameTrace stage of the processor
+        std::vector< unsigned > successors;  ///< Tasks that wait for this one
+        unsigned dependencies = 0;           ///< Number of tasks this one waits for
+        std::atomic< unsigned > remaining{0}; ///< Dependencies not finished in the current run
+    };
+    /// \brief Ring of task indices, sized for all tasks of a frame, so a run allocates nothing.
+    struct Queue {
+        std::mutex mutex;
+        std::vector< unsigned > ring;
+        size_t head = 0;  ///< Oldest task
+        size_t count = 0; ///< Queued tasks
+    };
+
+    /// \brief Build the task graph for frames with `channelCount` channels.
+    void build( unsigned channelCount );
+    void execute( unsigned task, unsigned worker );
+    void push( unsigned worker, unsigned task );
+    /// \brief Take the newest task of the own queue or steal the oldest one of another queue.
+    bool take( unsigned worker, unsigned &task );
+    void work( unsigned worker );
+
+    std::vector< Processor * > processors;
+    std::vector< std::unique_ptr< Task > > tasks;
+    std::vector< unsigned > roots; ///< Tasks without dependencies
+    unsigned builtChannels = 0;
+    bool built = false;
+
+    std::vector< std::unique_ptr< Queue > > queues; ///< One per worker, [0] is the thread of run()
+    std::vector< std::thread > threads;
+    PPresult *current = nullptr;
+    std::atomic< unsigned > queued{0};     ///< Tasks in all queues
+    std::atomic< unsigned > unfinished{0}; ///< Tasks of the current run that are not done yet
+    std::mutex wakeMutex;
+    std::condition_variable wake; ///< A task was queued or the run is complete
+    bool quit = false;
+    int verboseLevel = 0;
+};
@@ -30,14 +30,22 @@ class SpectrumGenerator : public Processor {
     ~SpectrumGenerator() override;
 
   private:
+    /// \brief What a channel task keeps between the frames, the channels are processed concurrently.
+    struct ChannelState {
+        Dso::WindowFunction windowFunction = Dso::WindowFunction( -1 ); ///< The dft window function of `window`
+        std::vector< double > window;                                   ///< storage for the tapering window
+//        fftw_plan fftPlan_R2HC = nullptr;
+//        fftw_plan fftPlan_HC2R = nullptr;
+    };
     const DsoSettingsScope *scope;
     const DsoSettingsAnalysis *analysis;
-    Dso::WindowFunction previousWindowFunction = Dso::WindowFunction( -1 ); ///< The previously used dft window function
-    std::vector< double > window;                                           ///< storage for the tapering window
-//    fftw_plan fftPlan_R2HC = nullptr;
-//    fftw_plan fftPlan_HC2R = nullptr;
-    QString note;
-    const QString &calculateNote( double frequency );
-    // Processor interface
-    void process( PPresult *data ) override;
+    std::vector< ChannelState > channelStates; ///< One per channel, sized by prepare()
+    static QString calculateNote( double frequency );
+    // Processor interface, one task per channel, each with its own window and fft buffers
+    Products inputs() const override { return Samples; }
+    const char *name() const override { return "spectrum"; }
+    Products outputs() const override { return Spectrum; }
+    bool perChannel() const override { return true; }
+    void prepare( PPresult *result ) override;
+    void processChannel( PPresult *result, ChannelID channel ) override;
 };
@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <algorithm>
+
+#include <QDebug>
+#include <QGuiApplication>
+#include <QScreen>
+
+#include "renderscheduler.h"
+#include "utils/frametrace.h"
+
+
+RenderScheduler::RenderScheduler( int verboseLevel, QObject *parent ) : QObject( parent ), verboseLevel( verboseLevel ) {
+    const QScreen *screen = QGuiApplication::primaryScreen();
+    const double refreshRate = screen && screen->refreshRate() >= 1.0 ? screen->refreshRate() : 60.0;
+    refreshInterval = int64_t( 1e9 / refreshRate );
+    if ( verboseLevel > 1 )
+        qDebug() << " RenderScheduler::RenderScheduler()" << refreshRate << "Hz";
+    timer.setSingleShot( true );
+    timer.setTimerType( Qt::PreciseTimer );
+    connect( &timer, &QTimer::timeout, this, &RenderScheduler::refresh );
+    presentTimeout.setSingleShot( true );
+    presentTimeout.setInterval( 100 ); // ms, a hidden scope does not block the processing
+    connect( &presentTimeout, &QTimer::timeout, this, &RenderScheduler::release );
+}
+
+
+RenderScheduler::Statistics RenderScheduler::statistics() const {
+    Statistics statistics = counters;
+    if ( FrameTrace::now() - lastPresented > 2 * 1000000000LL ) // nothing shown lately
+        statistics.fps = 0.0;
+    return statistics;
+}
+
+
+void RenderScheduler::input( std::shared_ptr< PPresult > frame ) {
+    ++counters.received;
+    pending = std::move( frame );
+    schedule();
+}
+
+
+void RenderScheduler::presented() {
+    if ( !presenting )
+        return;
+    lastPresented = FrameTrace::now();
+    ++counters.shown;
+    if ( lastPresented - rateStart >= 1000000000LL ) {
+        counters.fps = double( counters.shown - rateShown ) * 1e9 / double( lastPresented - rateStart );
+        rateStart = lastPresented;
+        rateShown = counters.shown;
+        if ( verboseLevel > 2 )
+            qDebug() << "  RenderScheduler::presented()" << counters.fps << "fps";
+    }
+    release();
+}
+
+
+void RenderScheduler::schedule() {
+    if ( !pending || presenting || timer.isActive() )
+        return;
+    // right away if the last refresh is long ago, rounded up since the timer has ms resolution
+    const int64_t wait = std::max( lastShown + refreshInterval - FrameTrace::now(), int64_t( 0 ) );
+    timer.start( int( ( wait + 999999 ) / 1000000 ) );
+}
+
+
+void RenderScheduler::refresh() {
+    if ( !pending || presenting )
+        return;
+    const std::shared_ptr< PPresult > frame = std::move( pending );
+    pending.reset();
+    lastShown = FrameTrace::now();
+    presenting = true;
+    presentTimeout.start();
+    emit show( frame );
+}
+
+
+void RenderScheduler::release() {
+    presenting = false;
+    presentTimeout.stop();
+    emit frameWanted(); // the post processing works on the next frame
+    schedule();
+}
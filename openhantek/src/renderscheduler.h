@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+#include <QObject>
+#include <QTimer>
+
+#include "post/ppresult.h"
+
+/// \brief Paces the display: at most one new frame per refresh of the screen, always the newest one.
+///
+/// The processed frames arrive with input() and wait for the next refresh, a newer frame replaces a waiting one.
+/// At the refresh the frame is handed to the scopes (show()). Only when a scope has swapped a painted frame
+/// (presented(), from QOpenGLWidget::frameSwapped) the post processing is asked for the next one (frameWanted())
+/// and the next frame may be shown, so a paint that takes longer than a refresh interval slows the display down
+/// instead of uploading frames that are never painted. A paced PostProcessing finishes no other frame meanwhile,
+/// the input frames in between are coalesced in its mailbox, so no vertices are generated for frames that would
+/// never be shown and the queued frames can no longer starve the user interaction.
+class RenderScheduler : public QObject {
+    Q_OBJECT
+
+  public:
+    struct Statistics {
+        uint64_t received = 0; ///< Frames that arrived from the post processing
+        uint64_t shown = 0;    ///< ... painted and swapped by the scopes
+        double fps = 0.0;      ///< Frames shown per second, measured over the last second
+    };
+
+    explicit RenderScheduler( int verboseLevel = 0, QObject *parent = nullptr );
+    Statistics statistics() const;
+
+  public slots:
+    /// \brief A processed frame, shown at the next refresh unless a newer one arrives before.
+    void input( std::shared_ptr< PPresult > frame );
+    /// \brief A scope has swapped a painted frame to the screen.
+    void presented();
+
+  signals:
+    /// \brief Show `frame` now, emitted at most once per refresh interval.
+    void show( std::shared_ptr< PPresult > frame );
+    /// \brief The shown frame was painted, the post processing may finish the next one.
+    void frameWanted();
+
+  private:
+    /// \brief Start the timer of the next refresh if a frame waits and the shown one was presented.
+    void schedule();
+    /// \brief The refresh, hands the waiting frame to the scopes.
+    void refresh();
+    /// \brief The shown frame is done, ask for the next one.
+    void release();
+
+    QTimer timer;
+    QTimer presentTimeout;               ///< Releases the frame if no scope paints, e.g. in a minimized window
+    int64_t refreshInterval;             ///< ns, of the primary screen
+    int64_t lastShown = 0;               ///< Time (FrameTrace::now()) of the last show()
+    int64_t lastPresented = 0;           ///< ... and of the last presented()
+    bool presenting = false;             ///< A frame was shown and not yet presented
+    std::shared_ptr< PPresult > pending; ///< The newest frame, waiting for the refresh
+    Statistics counters;
+    int64_t rateStart = 0;  ///< Begin of the interval the frame rate is measured in
+    uint64_t rateShown = 0; ///< ... and the shown frames at its begin
+    int verboseLevel = 0;
+};
@@ -4,6 +4,7 @@
 
 #include <QPointF>
 #include <QString>
+#include <QStringList>
 
 #include "hantekdso/controlspecification.h"
 #include "hantekdso/enums.h"
@@ -39,6 +40,19 @@ struct DsoSettingsScopeHorizontal {
     double calfreq = 1e3; ///< The frequency of the calibration output
 };
 
+/// \brief Holds the followed log files, the stream addresses and the retention limits of the input channel store.
+struct DsoSettingsScopeInput {
+    QStringList logFiles;            ///< "prefix=file" or "file", each one is followed by its own reader thread
+    QStringList streams;             ///< "prefix=address" or "address", local socket name or "tcp:<port>"
+    bool logCache = true;            ///< Keep the parsed samples of a log in a binary sidecar for a fast reopen
+    QStringList subscriptions;       ///< Wildcard patterns of "prefix:name" that are always parsed, e.g. "*:Frame*"
+    bool backfillOnSubscribe = true; ///< Re-scan a log for the history of a channel that is subscribed later
+    double retentionTime = 600.0;    ///< Keep the samples of the last n seconds per channel
+    unsigned retentionSamples = 0;   ///< Keep the last n samples per channel, overrides retentionTime if > 0
+    unsigned memoryBudget = 256;     ///< Upper limit in MiB for the samples of all channels together
+    unsigned frameSlots = 1;         ///< Pending frames for the post processing, 1 = only the newest one
+};
+
 /// \brief Holds the settings for the trigger.
 /// TODO Use ControlSettingsTrigger
 struct DsoSettingsScopeTrigger {
@@ -93,6 +107,7 @@ struct DsoSettingsScope {
     DsoSettingsScopeHorizontal horizontal;                       ///< Settings for the horizontal axis
     DsoSettingsScopeTrigger trigger;                             ///< Settings for the trigger
     DsoSettingsScopeAnalysis analysis;                           ///< Settings for the analysis
+    DsoSettingsScopeInput input;                                 ///< Settings for the input channel store
 
     int verboseLevel = 0;
     int toolTipVisible = 1; // show hints for beginners, can be disabled in settings dialog
@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include <QFile>
+#include <QTextStream>
+#include <QThread>
+
+#include "frametrace.h"
+
+
+// static
+FrameTrace &FrameTrace::instance() {
+    static FrameTrace trace;
+    return trace;
+}
+
+
+// static
+int64_t FrameTrace::now() {
+    return std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now().time_since_epoch() )
+        .count();
+}
+
+
+unsigned FrameTrace::stage( const char *name ) {
+    std::lock_guard< std::mutex > lock( mutex );
+    const unsigned stages = stageCount.load();
+    for ( unsigned id = 0; id < stages; ++id )
+        if ( !strcmp( counters[ id ].name.load(), name ) )
+            return id;
+    if ( stages == maxStages ) // shares the last stage, but never overflows
+        return maxStages - 1;
+    counters[ stages ].name.store( name );
+    stageCount.store( stages + 1 );
+    return stages;
+}
+
+
+void FrameTrace::span( unsigned stage, int64_t begin, int64_t end, unsigned tag, int channel ) {
+    const int64_t duration = std::max( end - begin, int64_t( 0 ) );
+    Counters &counter = counters[ stage ];
+    unsigned bucket = 0;
+    for ( int64_t micros = duration / 1000; micros && bucket < bucketCount - 1; micros >>= 1 )
+        ++bucket;
+    counter.buckets[ bucket ].fetch_add( 1, std::memory_order_relaxed );
+    counter.sum.fetch_add( duration, std::memory_order_relaxed );
+    int64_t max = counter.max.load( std::memory_order_relaxed );
+    while ( duration > max && !counter.max.compare_exchange_weak( max, duration, std::memory_order_relaxed ) ) {
+    }
+    counter.count.fetch_add( 1, std::memory_order_relaxed );
+
+    if ( !recording.load( std::memory_order_relaxed ) )
+        return;
+    const unsigned thread = threadId();
+    std::lock_guard< std::mutex > lock( mutex );
+    if ( events.size() < maxEvents )
+        events.push_back( {stage, thread, tag, channel, begin, duration} );
+    else
+        ++droppedEvents;
+}
+
+
+std::vector< FrameTrace::Histogram > FrameTrace::histograms() const {
+    std::vector< Histogram > result( stageCount.load() );
+    for ( size_t id = 0; id < result.size(); ++id ) {
+        const Counters &counter = counters[ id ];
+        Histogram &histogram = result[ id ];
+        histogram.name = counter.name.load();
+        histogram.sum = counter.sum.load( std::memory_order_relaxed );
+        histogram.max = counter.max.load( std::memory_order_relaxed );
+        for ( unsigned bucket = 0; bucket < bucketCount; ++bucket ) {
+            histogram.buckets[ bucket ] = counter.buckets[ bucket ].load( std::memory_order_relaxed );
+            histogram.count += histogram.buckets[ bucket ]; // matches the buckets even while spans come in
+        }
+    }
+    return result;
+}
+
+
+void FrameTrace::reset() {
+    for ( unsigned id = 0; id < stageCount.load(); ++id ) {
+        Counters &counter = counters[ id ];
+        for ( std::atomic< uint64_t > &bucket : counter.buckets )
+            bucket.store( 0, std::memory_order_relaxed );
+        counter.count.store( 0, std::memory_order_relaxed );
+        counter.sum.store( 0, std::memory_order_relaxed );
+        counter.max.store( 0, std::memory_order_relaxed );
+    }
+}
+
+
+int64_t FrameTrace::Histogram::quantile( double q ) const {
+    if ( !count )
+        return 0;
+    const double rank = q * double( count );
+    uint64_t below = 0;
+    for ( unsigned bucket = 0; bucket < bucketCount; ++bucket ) {
+        if ( !buckets[ bucket ] || double( below + buckets[ bucket ] ) < rank ) {
+            below += buckets[ bucket ];
+            continue;
+        }
+        const double low = bucket ? double( int64_t( 1000 ) << ( bucket - 1 ) ) : 0.0;
+        const double high = double( int64_t( 1000 ) << bucket );
+        const double position = ( rank - double( below ) ) / double( buckets[ bucket ] );
+        return std::min( int64_t( low + position * ( high - low ) ), max );
+    }
+    return max;
+}
+
+
+void FrameTrace::startRecording( const QString &fileName, size_t maxEvents ) {
+    std::lock_guard< std::mutex > lock( mutex );
+    recordingFileName = fileName;
+    this->maxEvents = maxEvents;
+    events.clear();
+    events.reserve( std::min( maxEvents, size_t( 1 ) << 16 ) );
+    droppedEvents = 0;
+    recording.store( true );
+}
+
+
+unsigned FrameTrace::threadId() {
+    thread_local unsigned id = 0; // 0: not known yet, else index + 1
+    if ( !id ) {
+        std::lock_guard< std::mutex > lock( mutex );
+        const QString name = QThread::currentThread()->objectName();
+        threadNames.push_back( name.isEmpty() ? QString( "thread %1" ).arg( threadNames.size() + 1 ) : name );
+        id = unsigned( threadNames.size() );
+    }
+    return id - 1;
+}
+
+
+bool FrameTrace::writeRecording() {
+    std::lock_guard< std::mutex > lock( mutex );
+    if ( !recording.load() )
+        return false;
+    recording.store( false );
+    QFile file( recordingFileName );
+    if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text ) )
+        return false;
+    // Chrome trace event format: complete events ("X") with µs time stamps, relative to the first one
+    int64_t origin = events.empty() ? 0 : events.front().begin;
+    for ( const Event &event : events )
+        origin = std::min( origin, event.begin );
+    QTextStream out( &file );
+    out << "{\"traceEvents\":[\n";
+    for ( size_t thread = 0; thread < threadNames.size(); ++thread )
+        out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << thread << ",\"args\":{\"name\":\""
+            << QString( threadNames[ thread ] ).replace( '"', '\'' ) << "\"}},\n";
+    for ( const Event &event : events ) {
+        out << "{\"ph\":\"X\",\"name\":\"" << counters[ event.stage ].name.load() << "\",\"pid\":1,\"tid\":" << event.thread
+            << ",\"ts\":" << QString::number( double( event.begin - origin ) / 1e3, 'f', 3 )
+            << ",\"dur\":" << QString::number( double( event.duration ) / 1e3, 'f', 3 ) << ",\"args\":{\"tag\":" << event.tag;
+        if ( event.channel >= 0 )
+            out << ",\"channel\":" << event.channel;
+        out << "}},\n";
+    }
+    out << "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":1,\"args\":{\"name\":\"OpenHantek\",\"dropped events\":"
+        << droppedEvents << "}}\n]}\n";
+    events.clear();
+    events.shrink_to_fit();
+    return out.status() == QTextStream::Ok;
+}
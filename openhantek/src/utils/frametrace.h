@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <QString>
+
+
+/// \brief Times (steady clock, ns) at which a frame passed the stages before the post processing.
+struct FrameStamps {
+    int64_t read = 0;      ///< The newest bytes of the frame were read by their source
+    int64_t parsed = 0;    ///< ... parsed and published
+    int64_t built = 0;     ///< DsoInput handed the frame to the mailbox
+    int64_t processed = 0; ///< The post processing finished it
+};
+
+
+/// \brief Latency of the acquisition-to-pixel pipeline, per stage and per frame tag.
+///
+/// Every stage reports spans (begin, end) with the tag of its frame. The durations are counted in a
+/// log2 histogram per stage (lock free, always on), the diagnostics dock shows their quantiles.
+/// With startRecording() the spans are also kept and written as Chrome trace JSON by writeRecording(),
+/// it can be loaded into chrome://tracing or ui.perfetto.dev.
+/// Stages are registered by name once, the name must be a string literal.
+class FrameTrace {
+  public:
+    static const unsigned maxStages = 32;
+    static const unsigned bucketCount = 40; ///< Bucket n counts durations < 2^n µs, the last one everything above
+
+    struct Histogram {
+        const char *name = nullptr;
+        uint64_t count = 0;
+        int64_t sum = 0; ///< ns
+        int64_t max = 0; ///< ns
+        uint64_t buckets[ bucketCount ] = {};
+        /// \brief Upper bound (ns) of the duration of the fraction `q` (0..1) of all spans, interpolated in its bucket.
+        int64_t quantile( double q ) const;
+    };
+
+    static FrameTrace &instance();
+    /// \brief Steady clock in ns, the time base of all stamps.
+    static int64_t now();
+
+    /// \brief Id of the stage `name`, registered on first use. Cache it, the lookup takes a lock.
+    unsigned stage( const char *name );
+    /// \brief Count the span `begin`..`end` (ns) of `stage` for frame `tag` (0: not yet part of a frame).
+    void span( unsigned stage, int64_t begin, int64_t end, unsigned tag = 0, int channel = -1 );
+
+    /// \brief Consistent enough copies of the histograms of all registered stages, for display.
+    std::vector< Histogram > histograms() const;
+    /// \brief Clear the histograms, the registered stages stay.
+    void reset();
+
+    /// \brief Keep all spans from now on, up to `maxEvents`, for writeRecording().
+    void startRecording( const QString &fileName, size_t maxEvents = 4000000 );
+    bool isRecording() const { return recording.load( std::memory_order_relaxed ); }
+    /// \brief Write the recorded spans as Chrome trace JSON to the file of startRecording().
+    bool writeRecording();
+
+  private:
+    FrameTrace() = default;
+    struct Counters {
+        std::atomic< const char * > name{nullptr};
+        std::atomic< uint64_t > count{0};
+        std::atomic< int64_t > sum{0};
+        std::atomic< int64_t > max{0};
+        std::atomic< uint64_t > buckets[ bucketCount ] = {};
+    };
+    struct Event {
+        unsigned stage;
+        unsigned thread;
+        unsigned tag;
+        int channel;
+        int64_t begin;
+        int64_t duration;
+    };
+    /// \brief Small id of the calling thread, its name is remembered for the trace.
+    unsigned threadId();
+
+    Counters counters[ maxStages ];
+    std::atomic< unsigned > stageCount{0};
+    std::atomic< bool > recording{false};
+    mutable std::mutex mutex; ///< Guards the registration and the recording
+    std::vector< Event > events;
+    size_t maxEvents = 0;
+    size_t droppedEvents = 0;
+    std::vector< QString > threadNames;
+    QString recordingFileName;
+};
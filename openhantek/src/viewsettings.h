@@ -43,7 +43,7 @@ struct DsoSettingsView {
                                      std::vector< QColor >(),          std::vector< QColor >() };         // spectrum, voltage
     bool antialiasing = true;                                         ///< Antialiasing for the graphs
     bool digitalPhosphor = false;                                     ///< true slowly fades out the previous graphs
-    unsigned digitalPhosphorDepth = 8;                                ///< Number of channels shown at one time
+    unsigned digitalPhosphorDepth = 8;                                ///< Frames until a trace fades to 10 %
     Dso::InterpolationMode interpolation = Dso::INTERPOLATION_LINEAR; ///< Interpolation mode for the graph
     bool printerColorImages = true;                                   ///< Exports images with screen colors
     int zoomHeightIndex = 2;                                          ///< Zoom scope window height
@@ -58,5 +58,4 @@ struct DsoSettingsView {
     unsigned screenHeight = 0;
     unsigned screenWidth = 0;
     unsigned maxChannels = 0;
-    unsigned digitalPhosphorDraws() const { return digitalPhosphor ? digitalPhosphorDepth : 1; }
 };
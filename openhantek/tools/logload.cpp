@@ -0,0 +1,221 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// Load generator for the log input of OpenHantek.
+// Writes an Unreal style log with "ScopeData:" lines to a file or to stdout (e.g. a pipe), optionally
+// interleaved with ordinary log lines, in bursts at a given average line rate. The same seed gives the
+// same log byte for byte, only the pacing depends on the machine. Reports the sustained values/s on stderr.
+//
+// Usage: logload [--output <file>|-] [--append] [--channels n] [--rate lines/s, 0: unthrottled] [--seconds s]
+//                [--lines n] [--burst lines] [--noise lines per scope line] [--shape sine|saw|square|random|mixed]
+//                [--seed n]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+/// \brief Deterministic on every platform, unlike the distributions of <random>.
+class XorShift {
+  public:
+    explicit XorShift( uint64_t seed ) : state( seed * 0x9E3779B97F4A7C15ull + 1 ) {}
+    uint64_t next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+    /// \brief Uniform in [0, 1).
+    double uniform() { return double( next() >> 11 ) * ( 1.0 / 9007199254740992.0 ); }
+
+  private:
+    uint64_t state;
+};
+
+
+enum class Shape { Sine, Saw, Square, Random, Mixed };
+
+
+/// \brief Append `value` with three decimals, much faster than printf for the bulk of the output.
+static void appendFixed( std::string &out, double value ) {
+    long long scaled = std::llround( value * 1000.0 );
+    if ( scaled < 0 ) {
+        out += '-';
+        scaled = -scaled;
+    }
+    char digits[ 24 ];
+    int count = 0;
+    do {
+        digits[ count++ ] = char( '0' + scaled % 10 );
+        scaled /= 10;
+    } while ( scaled || count < 4 ); // at least "0.000"
+    while ( count > 3 )
+        out += digits[ --count ];
+    out += '.';
+    while ( count > 0 )
+        out += digits[ --count ];
+}
+
+
+/// \brief Prefix of an Unreal log line, "[2024.05.06-07.08.09:123][ 17]", for `t` seconds after the start.
+static void appendPrefix( std::string &out, double t, uint64_t frame ) {
+    const long long ms = static_cast< long long >( t * 1000.0 );
+    const long long s = ms / 1000;
+    char buffer[ 48 ];
+    snprintf( buffer, sizeof( buffer ), "[2024.05.06-%02lld.%02lld.%02lld:%03lld][%3u]", ( s / 3600 ) % 24, ( s / 60 ) % 60,
+              s % 60, ms % 1000, unsigned( frame % 1000 ) );
+    out += buffer;
+}
+
+
+int main( int argc, char *argv[] ) {
+    std::string output = "-";
+    bool append = false;
+    unsigned channels = 16;
+    double rate = 1000;    // scope lines per second, 0: as fast as possible
+    double seconds = 10;
+    uint64_t maxLines = 0; // 0: no limit
+    unsigned burst = 1;    // scope lines written back to back, then a pause keeps the average rate
+    double noise = 0;      // ordinary log lines per scope line
+    Shape shape = Shape::Mixed;
+    uint64_t seed = 1;
+    for ( int i = 1; i < argc; ++i ) {
+        std::string option = argv[ i ];
+        if ( option == "--append" ) {
+            append = true;
+            continue;
+        }
+        const char *value = i + 1 < argc ? argv[ ++i ] : nullptr;
+        if ( !value )
+            option.clear();
+        if ( option == "--output" )
+            output = value;
+        else if ( option == "--channels" )
+            channels = unsigned( std::max( 1, atoi( value ) ) );
+        else if ( option == "--rate" )
+            rate = std::max( 0.0, atof( value ) );
+        else if ( option == "--seconds" )
+            seconds = atof( value );
+        else if ( option == "--lines" )
+            maxLines = strtoull( value, nullptr, 10 );
+        else if ( option == "--burst" )
+            burst = unsigned( std::max( 1, atoi( value ) ) );
+        else if ( option == "--noise" )
+            noise = std::max( 0.0, atof( value ) );
+        else if ( option == "--seed" )
+            seed = strtoull( value, nullptr, 10 );
+        else if ( option == "--shape" && !strcmp( value, "sine" ) )
+            shape = Shape::Sine;
+        else if ( option == "--shape" && !strcmp( value, "saw" ) )
+            shape = Shape::Saw;
+        else if ( option == "--shape" && !strcmp( value, "square" ) )
+            shape = Shape::Square;
+        else if ( option == "--shape" && !strcmp( value, "random" ) )
+            shape = Shape::Random;
+        else if ( option == "--shape" && !strcmp( value, "mixed" ) )
+            shape = Shape::Mixed;
+        else {
+            fprintf( stderr,
+                     "usage: %s [--output <file>|-] [--append] [--channels n] [--rate lines/s, 0: unthrottled] [--seconds s]\n"
+                     "       [--lines n] [--burst lines] [--noise lines per scope line] "
+                     "[--shape sine|saw|square|random|mixed] [--seed n]\n",
+                     argv[ 0 ] );
+            return 1;
+        }
+    }
+
+    FILE *file = output == "-" ? stdout : fopen( output.c_str(), append ? "ab" : "wb" );
+    if ( !file ) {
+        fprintf( stderr, "could not open %s\n", output.c_str() );
+        return 1;
+    }
+    static const char *const noiseLines[] = {
+        "LogTemp: Display: Streaming level loaded in 12.5 ms",
+        "LogNet: Warning: Connection saturated, 3 packets delayed",
+        "LogRenderer: Reallocating scene render targets to support 1920x1080",
+        "LogScript: Warning: Accessed None trying to read property CachedActor",
+        "LogGarbage: Collecting garbage took 4.2 ms, 1532 objects purged",
+    };
+    std::vector< std::string > names;
+    for ( unsigned channel = 0; channel < channels; ++channel )
+        names.push_back( ", Channel" + std::to_string( channel ) + ": " );
+
+    XorShift random( seed );
+    const double nominalRate = rate > 0 ? rate : 60.0; // time stamps of an unthrottled log advance at 60 lines/s
+    std::string buffer;
+    buffer.reserve( 1 << 20 );
+    typedef std::chrono::steady_clock Clock;
+    const auto start = Clock::now();
+    uint64_t lines = 0;
+    uint64_t values = 0;
+    uint64_t noiseWritten = 0;
+    double noiseDue = 0.0;
+    for ( ;; ) {
+        const double elapsed = std::chrono::duration< double >( Clock::now() - start ).count();
+        if ( ( seconds > 0 && elapsed >= seconds ) || ( maxLines && lines >= maxLines ) )
+            break;
+        if ( rate > 0 && double( lines ) >= elapsed * rate ) { // ahead of schedule, the next burst is not due
+            std::this_thread::sleep_for( std::chrono::microseconds( 200 ) );
+            continue;
+        }
+        for ( unsigned b = 0; b < burst && !( maxLines && lines >= maxLines ); ++b, ++lines ) {
+            const double t = double( lines ) / nominalRate;
+            for ( noiseDue += noise; noiseDue >= 1.0; noiseDue -= 1.0, ++noiseWritten ) {
+                appendPrefix( buffer, t, lines );
+                buffer += noiseLines[ random.next() % ( sizeof( noiseLines ) / sizeof( *noiseLines ) ) ];
+                buffer += '\n';
+            }
+            appendPrefix( buffer, t, lines );
+            buffer += "LogScope: Display: ScopeData: Time: ";
+            appendFixed( buffer, t );
+            for ( unsigned channel = 0; channel < channels; ++channel ) {
+                const double phase = t * 0.5 * ( 1.0 + channel ) + 0.1 * channel;
+                const double fraction = phase - std::floor( phase );
+                const Shape channelShape = shape == Shape::Mixed ? Shape( channel % 4 ) : shape;
+                double value;
+                switch ( channelShape ) {
+                case Shape::Sine:
+                    value = std::sin( 2 * M_PI * phase );
+                    break;
+                case Shape::Saw:
+                    value = 2 * fraction - 1;
+                    break;
+                case Shape::Square:
+                    value = fraction < 0.5 ? 1.0 : -1.0;
+                    break;
+                default:
+                    value = 2 * random.uniform() - 1;
+                    break;
+                }
+                buffer += names[ channel ];
+                appendFixed( buffer, 10.0 * ( channel + 1 ) + 5.0 * value );
+            }
+            buffer += '\n';
+            values += channels;
+        }
+        // a throttled burst is flushed at once, the tailer sees it as one append; unthrottled in large blocks
+        if ( rate > 0 || buffer.size() >= ( 1 << 20 ) - 4096 ) {
+            fwrite( buffer.data(), 1, buffer.size(), file );
+            fflush( file );
+            buffer.clear();
+        }
+        if ( ferror( file ) ) // e.g. the reading end of the pipe was closed
+            break;
+    }
+    fwrite( buffer.data(), 1, buffer.size(), file );
+    fflush( file );
+    const bool ok = !ferror( file );
+    if ( file != stdout )
+        fclose( file );
+    const double elapsed = std::chrono::duration< double >( Clock::now() - start ).count();
+    fprintf( stderr, "channels=%u lines=%llu noise_lines=%llu values=%llu seconds=%.3f values_per_s=%.0f ok=%d\n", channels,
+             static_cast< unsigned long long >( lines ), static_cast< unsigned long long >( noiseWritten ),
+             static_cast< unsigned long long >( values ), elapsed, double( values ) / elapsed, ok ? 1 : 0 );
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,161 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+// Header only producer side of the OpenHantek streaming input (see openhantek/src/input/streamprotocol.h).
+// Usage:
+//   ScopeStreamClient client;
+//   client.connectLocal( "/tmp/openhantek" );      // or client.connectTcp( 5555 )
+//   uint16_t fps = client.declare( "FrameTime" );
+//   client.beginSamples( nowNs );
+//   client.addSample( fps, 16.6f );
+//   client.endSamples();                            // sends the batch
+// No dependencies besides the C++ standard library and the socket API of the platform.
+
+#include <cstdint>
+#include <string>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET ScopeStreamSocket;
+static const ScopeStreamSocket scopeStreamInvalidSocket = INVALID_SOCKET;
+#else
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+typedef int ScopeStreamSocket;
+static const ScopeStreamSocket scopeStreamInvalidSocket = -1;
+#endif
+
+#include "../src/input/streamprotocol.h"
+
+
+class ScopeStreamClient {
+  public:
+    ScopeStreamClient() = default;
+    ~ScopeStreamClient() { disconnect(); }
+    ScopeStreamClient( const ScopeStreamClient & ) = delete;
+
+#ifndef _WIN32
+    /// \brief Connect to a StreamSource that listens on a Unix domain socket.
+    /// \param path Socket path, a plain name is located in /tmp like QLocalServer does.
+    bool connectLocal( const std::string &path ) {
+        disconnect();
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        const std::string fullPath = path.find( '/' ) == std::string::npos ? "/tmp/" + path : path;
+        if ( fullPath.size() >= sizeof( address.sun_path ) )
+            return false;
+        memcpy( address.sun_path, fullPath.c_str(), fullPath.size() + 1 );
+        socketHandle = ::socket( AF_UNIX, SOCK_STREAM, 0 );
+        if ( socketHandle == scopeStreamInvalidSocket )
+            return false;
+        if ( ::connect( socketHandle, reinterpret_cast< sockaddr * >( &address ), sizeof( address ) ) != 0 ) {
+            disconnect();
+            return false;
+        }
+        return sendHello();
+    }
+#endif
+
+    /// \brief Connect to a StreamSource that listens on loopback TCP ("tcp:<port>").
+    bool connectTcp( uint16_t port ) {
+        disconnect();
+#ifdef _WIN32
+        WSADATA wsaData;
+        if ( WSAStartup( MAKEWORD( 2, 2 ), &wsaData ) != 0 )
+            return false;
+#endif
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons( port );
+        address.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+        socketHandle = ::socket( AF_INET, SOCK_STREAM, IPPROTO_TCP );
+        if ( socketHandle == scopeStreamInvalidSocket )
+            return false;
+        int noDelay = 1; // every batch is sent at once, do not wait for more data
+        setsockopt( socketHandle, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast< const char * >( &noDelay ), sizeof( noDelay ) );
+        if ( ::connect( socketHandle, reinterpret_cast< sockaddr * >( &address ), sizeof( address ) ) != 0 ) {
+            disconnect();
+            return false;
+        }
+        return sendHello();
+    }
+
+    void disconnect() {
+        if ( socketHandle == scopeStreamInvalidSocket )
+            return;
+#ifdef _WIN32
+        closesocket( socketHandle );
+        WSACleanup();
+#else
+        ::close( socketHandle );
+#endif
+        socketHandle = scopeStreamInvalidSocket;
+    }
+
+    bool isConnected() const { return socketHandle != scopeStreamInvalidSocket; }
+
+    /// \brief Declare a channel and return its id for addSample(), the declaration is sent immediately.
+    uint16_t declare( const std::string &name ) {
+        const uint16_t id = nextId++;
+        encoder.declare( id, name );
+        flush();
+        return id;
+    }
+
+    void beginSamples( int64_t timestampNs ) {
+        encoder.beginSamples( timestampNs );
+        batchTime = timestampNs;
+    }
+    void addSample( uint16_t channel, float value ) {
+        if ( !encoder.addSample( channel, value ) ) { // frame is full, continue in a new one
+            encoder.endSamples();
+            encoder.beginSamples( batchTime );
+            encoder.addSample( channel, value );
+        }
+    }
+    /// \brief Close the batch and send it.
+    bool endSamples() {
+        encoder.endSamples();
+        return flush();
+    }
+
+    /// \brief Send everything that is encoded but not yet sent.
+    bool flush() {
+        size_t sent = 0;
+        while ( isConnected() && sent < encoder.size() ) {
+#ifdef _WIN32
+            const int n = ::send( socketHandle, reinterpret_cast< const char * >( encoder.data() + sent ), int( encoder.size() - sent ), 0 );
+#else
+#ifdef MSG_NOSIGNAL // a closed connection is reported as error and not as SIGPIPE
+            const ssize_t n = ::send( socketHandle, encoder.data() + sent, encoder.size() - sent, MSG_NOSIGNAL );
+#else
+            const ssize_t n = ::send( socketHandle, encoder.data() + sent, encoder.size() - sent, 0 );
+#endif
+#endif
+            if ( n <= 0 ) {
+                disconnect();
+                break;
+            }
+            sent += size_t( n );
+        }
+        encoder.clear();
+        return isConnected();
+    }
+
+  private:
+    bool sendHello() {
+        encoder.clear();
+        encoder.hello();
+        return flush();
+    }
+
+    ScopeStreamSocket socketHandle = scopeStreamInvalidSocket;
+    ScopeStream::Encoder encoder;
+    uint16_t nextId = 0;
+    int64_t batchTime = 0;
+};
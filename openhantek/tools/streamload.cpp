@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+// Load generator for the streaming input of OpenHantek.
+// Connects to a StreamSource, declares a number of channels and sends sine/saw/square values
+// at a given rate in batches, then reports the sustained values/s.
+//
+// Usage: streamload [--local <path> | --tcp <port>] [--channels n] [--rate values/s] [--batch lines]
+//                   [--seconds s]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "scopestreamclient.h"
+
+
+int main( int argc, char *argv[] ) {
+    std::string local = "openhantek";
+    int tcpPort = 0;
+    unsigned channels = 16;
+    double rate = 100000;  // values per second, all channels together
+    unsigned batch = 10;   // lines (one value per channel) per sent batch
+    double seconds = 10;
+    for ( int i = 1; i + 1 < argc; i += 2 ) {
+        const std::string option = argv[ i ];
+        const char *value = argv[ i + 1 ];
+        if ( option == "--local" )
+            local = value;
+        else if ( option == "--tcp" )
+            tcpPort = atoi( value );
+        else if ( option == "--channels" )
+            channels = unsigned( std::max( 1, atoi( value ) ) );
+        else if ( option == "--rate" )
+            rate = atof( value );
+        else if ( option == "--batch" )
+            batch = unsigned( std::max( 1, atoi( value ) ) );
+        else if ( option == "--seconds" )
+            seconds = atof( value );
+        else {
+            fprintf( stderr, "usage: %s [--local <path> | --tcp <port>] [--channels n] [--rate values/s] [--batch lines] [--seconds s]\n",
+                     argv[ 0 ] );
+            return 1;
+        }
+    }
+
+    ScopeStreamClient client;
+#ifdef _WIN32
+    const bool connected = client.connectTcp( uint16_t( tcpPort ) );
+#else
+    const bool connected = tcpPort ? client.connectTcp( uint16_t( tcpPort ) ) : client.connectLocal( local );
+#endif
+    if ( !connected ) {
+        fprintf( stderr, "could not connect\n" );
+        return 1;
+    }
+    std::vector< uint16_t > ids;
+    for ( unsigned channel = 0; channel < channels; ++channel )
+        ids.push_back( client.declare( "Load" + std::to_string( channel ) ) );
+
+    typedef std::chrono::steady_clock Clock;
+    const double linesPerSecond = rate / channels;
+    const auto start = Clock::now();
+    uint64_t lines = 0;
+    uint64_t values = 0;
+    for ( ;; ) {
+        const double elapsed = std::chrono::duration< double >( Clock::now() - start ).count();
+        if ( elapsed >= seconds || !client.isConnected() )
+            break;
+        const uint64_t due = uint64_t( elapsed * linesPerSecond );
+        if ( lines >= due ) { // ahead of schedule
+            std::this_thread::sleep_for( std::chrono::microseconds( 200 ) );
+            continue;
+        }
+        for ( unsigned b = 0; b < batch && lines < due + batch; ++b, ++lines ) {
+            const double t = lines / linesPerSecond;
+            client.beginSamples( int64_t( t * 1e9 ) );
+            for ( unsigned channel = 0; channel < channels; ++channel ) {
+                const double phase = t * ( 1.0 + channel ) + channel;
+                float value;
+                switch ( channel % 3 ) {
+                case 0:
+                    value = float( std::sin( 2 * M_PI * phase ) );
+                    break;
+                case 1:
+                    value = float( 2 * ( phase - std::floor( phase ) ) - 1 );
+                    break;
+                default:
+                    value = phase - std::floor( phase ) < 0.5 ? 1.0f : -1.0f;
+                    break;
+                }
+                client.addSample( ids[ channel ], value );
+            }
+            client.endSamples();
+            values += channels;
+        }
+    }
+    const double elapsed = std::chrono::duration< double >( Clock::now() - start ).count();
+    printf( "channels=%u lines=%llu values=%llu seconds=%.3f values_per_s=%.0f connected=%d\n", channels,
+            static_cast< unsigned long long >( lines ), static_cast< unsigned long long >( values ), elapsed, values / elapsed,
+            client.isConnected() ? 1 : 0 );
+    return client.isConnected() ? 0 : 1;
+}